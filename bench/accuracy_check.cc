@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "argh.h"
+
+extern "C" {
+#include "include/libastro.h"
+}
+
+#include "model/angle.cc"
+#include "model/nightgrid.cc"
+#include "model/object.cc"
+#include "model/skyindex.cc"
+#include "model/synthetic.cc"
+#include "model/telescope.cc"
+#include "model/window.cc"
+#include "schedule.cc"
+
+// Runs the candidate search of the scheduler, with its night grid,
+// hour angle bound and Moon cone queries, next to the reference libastro
+// path of Telescope::IsObjectVisible() (moon(), now_lst() and hadec_aa() at
+// every slot) over random nights, sites and catalogs. Nights whose
+// candidates match give the same model, so their schedules can only differ
+// by the solver. The slew between two touching windows is checked first,
+// through the split of the night into components and a solve.
+struct Errors {
+    int Nights = 0;
+    int DifferingNights = 0;
+    double MoonDegrees = 0;
+    double LstSeconds = 0;
+    int MaxEdge = 0;
+    int64_t EdgeSum = 0;
+    int64_t Windows = 0;
+    int64_t OnlyFast = 0;
+    int64_t OnlyReference = 0;
+};
+
+void print_help() {
+    std::cout << "Usage scheduler_accuracy_check:" << std::endl;
+    std::cout << "  scheduler_accuracy_check [options]" << std::endl;
+    std::cout << "" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --nights <count>                Random nights, 20 by "
+                 "default"
+              << std::endl;
+    std::cout << "  -n, --objects <count>           Objects per night, 500 by "
+                 "default"
+              << std::endl;
+    std::cout << "  -s, --seed <seed>               Seed, 1 by default"
+              << std::endl;
+    std::cout << "  --max-edge-error <minutes>      Fail above this window "
+                 "edge error"
+              << std::endl;
+    std::cout << "  --max-differing <fraction>      Fail above this fraction "
+                 "of differing nights"
+              << std::endl;
+    std::cout << "  -h, --help                      Show this help"
+              << std::endl;
+}
+
+double Uniform(std::mt19937_64 &generator, double low, double high) {
+    return low + (high - low) * ((generator() >> 11) * 0x1.0p-53);
+}
+
+// Same night as FindCandidates() finds, `horizon` receives its length
+double Dusk(double julian_date, const Telescope &telescope, int &horizon) {
+    Now now;
+    now.n_mjd = julian_date;
+    now.n_lat = telescope.GetLatitude() * PI / 180;
+    now.n_lng = telescope.GetLongitude() * PI / 180;
+    now.n_elev = telescope.GetAltitude() / ERAD;
+    now.n_temp = 15;
+    now.n_dip = now.n_tz = 0;
+    now.n_pressure = 1010;
+    now.n_epoch = J2000;
+
+    double dawn, dusk;
+    int status;
+    twilight_cir(&now, -17.5 * PI / 180, &dawn, &dusk, &status);
+    horizon = trunc((dusk - dawn) * 60 * 24);
+
+    return dusk;
+}
+
+// Windows, by object index, of the candidates found with the reference path
+std::map<int, Window> ReferenceWindows(const NightGrid &grid,
+                                       const Telescope &telescope,
+                                       const std::vector<Object> &objects) {
+    // Moon and sidereal time do not depend on the object
+    std::vector<double> moon_ra(grid.GetSlots()), moon_dec(grid.GetSlots());
+    std::vector<double> lst(grid.GetSlots());
+    for (int slot = 0; slot < grid.GetSlots(); slot++) {
+        NightGrid::Moon(grid.GetTime(slot), &moon_ra[slot], &moon_dec[slot]);
+        lst[slot] = telescope.GetLst(grid.GetTime(slot));
+    }
+
+    std::map<int, Window> windows;
+    for (size_t i = 0; i < objects.size(); i++) {
+        const Object &object = objects[i];
+        Visibility visibility =
+            Visibility::Scan(grid.GetSlots(), [&](int slot) {
+                if (telescope.IsNearMoon(moon_ra[slot], moon_dec[slot],
+                                         object.GetPosition()) ||
+                    !telescope.IsWithinLimits(lst[slot],
+                                              object.GetPosition())) {
+                    return false;
+                }
+
+                double alt, az;
+                hadec_aa(degrad(telescope.GetLatitude()),
+                         hrrad(Telescope::HourAngle(lst[slot],
+                                                    object.GetRa())),
+                         degrad(object.GetDec()), &alt, &az);
+
+                return raddeg(alt) >= telescope.GetMinAltitude();
+            });
+
+        Window window =
+            FindLongestWindow(visibility, object.GetObservationTime());
+        if (window.Start < grid.GetSlots()) {
+            windows[i] = window;
+        }
+    }
+
+    return windows;
+}
+
+// Error of the grid against the reference at a random instant of each slot
+void SampleGrid(const NightGrid &grid, const Telescope &telescope,
+                std::mt19937_64 &generator, Errors &errors) {
+    for (int slot = 0; slot < grid.GetSlots(); slot++) {
+        double time = grid.GetTime(slot) + Uniform(generator, 0, 1) / (24 * 60);
+
+        double ra, dec;
+        NightGrid::Moon(time, &ra, &dec);
+        errors.MoonDegrees = std::max(
+            errors.MoonDegrees,
+            raddeg(Angle::separation(degrad(dec), hrrad(ra),
+                                     degrad(grid.GetMoonDec(slot)),
+                                     hrrad(grid.GetMoonRa(slot)))
+                       .GetRadians()));
+
+        double lst = Telescope::HourAngle(telescope.GetLst(time),
+                                          grid.GetLst(slot));
+        errors.LstSeconds = std::max(errors.LstSeconds, fabs(lst) * 3600);
+    }
+}
+
+void Compare(const std::vector<Candidate> &candidates,
+             const std::map<int, Window> &reference, Errors &errors) {
+    bool differs = false;
+    std::map<int, Window> fast;
+    for (const Candidate &candidate : candidates) {
+        fast[candidate.ObjectIndex] = candidate.Visible;
+    }
+
+    for (const auto &window : fast) {
+        auto other = reference.find(window.first);
+        if (other == reference.end()) {
+            errors.OnlyFast++;
+            differs = true;
+            continue;
+        }
+
+        int edge = std::max(abs(window.second.Start - other->second.Start),
+                            abs(window.second.End - other->second.End));
+        errors.MaxEdge = std::max(errors.MaxEdge, edge);
+        errors.EdgeSum += edge;
+        errors.Windows++;
+        differs |= edge > 0;
+    }
+
+    for (const auto &window : reference) {
+        if (fast.find(window.first) == fast.end()) {
+            errors.OnlyReference++;
+            differs = true;
+        }
+    }
+
+    errors.Nights++;
+    errors.DifferingNights += differs;
+}
+
+// Two objects with touching windows on a slewing telescope, near the
+// meridian so both can be observed. They must share a component, and the
+// solved schedule must leave room for the slew between them.
+bool CheckTouchingWindows(double julian_date, const TelescopeLimits &limits) {
+    Telescope telescope(1, 0, 0, 0, "site", limits,
+                        TelescopeMount{1, 1, 90, 0});
+    int horizon;
+    double dusk = Dusk(julian_date, telescope, horizon);
+    NightGrid grid(dusk, horizon, 0);
+
+    std::vector<Object> objects = {Object(1, grid.GetLst(15), 0, 1, 30),
+                                   Object(2, grid.GetLst(47), 20, 1, 30)};
+    std::vector<Window> windows = {{0, 30}, {30, 65}};
+    std::vector<std::vector<Candidate>> candidates(1);
+    for (size_t i = 0; i < objects.size(); i++) {
+        auto curve = AirmassCurve::Compute(
+            telescope, grid, windows[i], objects[i].GetObservationTime(),
+            [&](double) { return objects[i].GetPosition(); },
+            AIRMASS_SEGMENTS, AIRMASS_TOLERANCE);
+        candidates[0].push_back(Candidate{0, (int)i, windows[i], curve,
+                                          objects[i].GetRa(),
+                                          objects[i].GetDec(), 0, {}});
+    }
+
+    std::vector<Telescope> telescopes = {telescope};
+    auto members = ConflictComponents(candidates, telescopes, objects, 0, {0});
+    if (members.size() != 1) {
+        std::cout << "ERR: Touching windows were split into "
+                  << members.size() << " components" << std::endl;
+        return false;
+    }
+
+    ComponentModel component;
+    std::vector<bool> hinted(objects.size(), false);
+    BuildComponent(component, telescopes, objects, candidates, members[0],
+                   {horizon}, {0}, {}, hinted);
+    SolveComponent(component, operations_research::sat::SatParameters(),
+                   nullptr);
+
+    auto first = std::make_tuple(1, 1);
+    auto second = std::make_tuple(1, 2);
+    const auto &response = component.Response;
+    if (!SolutionBooleanValue(response, component.Presences[first]) ||
+        !SolutionBooleanValue(response, component.Presences[second])) {
+        std::cout << "ERR: Touching windows were not both scheduled"
+                  << std::endl;
+        return false;
+    }
+
+    int64_t gap =
+        SolutionIntegerValue(response, component.Assigned[second]) -
+        SolutionIntegerValue(response, component.Assigned[first]) -
+        objects[0].GetObservationTime();
+    int slew = TransitionTime(telescope, candidates[0][0], candidates[0][1]);
+    std::cout << "touching_windows_gap_minutes: " << gap << " of " << slew
+              << std::endl;
+    if (gap < slew) {
+        std::cout << "ERR: Touching windows leave " << gap
+                  << " minutes for a " << slew << " minute slew"
+                  << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    argh::parser cmdl(argc, argv, argh::parser::PREFER_PARAM_FOR_UNREG_OPTION);
+
+    if (cmdl[{"-h", "--help"}]) {
+        print_help();
+        return EXIT_SUCCESS;
+    }
+
+    int nights = 20;
+    if (cmdl({"--nights"}) &&
+        (!(cmdl({"--nights"}) >> nights) || nights < 1)) {
+        std::cout << "ERR: Night count was not valid" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int count = 500;
+    if (cmdl({"-n", "--objects"}) &&
+        (!(cmdl({"-n", "--objects"}) >> count) || count < 1)) {
+        std::cout << "ERR: Object count was not valid" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint64_t seed = 1;
+    if (cmdl({"-s", "--seed"}) && !(cmdl({"-s", "--seed"}) >> seed)) {
+        std::cout << "ERR: Seed was not valid" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int max_edge_error = -1;
+    if (cmdl({"--max-edge-error"}) &&
+        (!(cmdl({"--max-edge-error"}) >> max_edge_error) ||
+         max_edge_error < 0)) {
+        std::cout << "ERR: Maximum edge error was not valid" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    double max_differing = -1;
+    if (cmdl({"--max-differing"}) &&
+        (!(cmdl({"--max-differing"}) >> max_differing) ||
+         max_differing < 0)) {
+        std::cout << "ERR: Maximum differing fraction was not valid"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Nights without astronomical darkness are skipped. Further than 100
+    // degrees from Greenwich twilight_cir() gives the dusk before the dawn of
+    // the same day, which the candidate search does not handle.
+    TelescopeLimits limits{};
+    limits.MinHeight = 30;
+    limits.MinLunarDistance = 20;
+    limits.MinDecNord = 90;
+    limits.MinDecSouth = 90;
+    limits.MountHA = 5;
+
+    double first_night;
+    cal_mjd(1, 1, 2020, &first_night);
+
+    if (!CheckTouchingWindows(first_night + 0.75, limits)) {
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937_64 generator(seed);
+    Errors errors;
+    for (int n = 0; n < nights; n++) {
+        double latitude = Uniform(generator, -60, 60);
+        double longitude = Uniform(generator, -100, 100);
+        int altitude = Uniform(generator, 0, 3000);
+        Telescope telescope(1, latitude, longitude, altitude, "site", limits);
+
+        // Local evening of a day of the decade
+        double julian_date = first_night +
+                             floor(Uniform(generator, 0, 3652)) +
+                             (18 - longitude / 15) / 24;
+
+        Synthetic synthetic(generator(), Synthetic::UNIFORM);
+        std::vector<Object> objects;
+        for (int i = 0; i < count; i++) {
+            objects.push_back(synthetic.Next(i + 1));
+        }
+        std::sort(objects.begin(), objects.end());
+        SkyIndex index(objects);
+
+        // The candidate search reports every object it adds
+        int horizon;
+        double dusk = Dusk(julian_date, telescope, horizon);
+        if (horizon <= 0) {
+            continue;
+        }
+
+        std::ostringstream log;
+        auto buffer = std::cout.rdbuf(log.rdbuf());
+        auto candidates = FindCandidates(julian_date, telescope, 0, objects,
+                                         index, {}, horizon, dusk);
+        std::cout.rdbuf(buffer);
+
+        NightGrid grid(dusk, horizon, longitude);
+        SampleGrid(grid, telescope, generator, errors);
+        Compare(candidates, ReferenceWindows(grid, telescope, objects),
+                errors);
+    }
+
+    double differing =
+        errors.Nights ? (double)errors.DifferingNights / errors.Nights : 0;
+    std::cout << "nights: " << errors.Nights << std::endl;
+    std::cout << "moon_max_error_degrees: " << errors.MoonDegrees << std::endl;
+    std::cout << "lst_max_error_seconds: " << errors.LstSeconds << std::endl;
+    std::cout << "windows_compared: " << errors.Windows << std::endl;
+    std::cout << "window_edge_max_minutes: " << errors.MaxEdge << std::endl;
+    std::cout << "window_edge_mean_minutes: "
+              << (errors.Windows ? (double)errors.EdgeSum / errors.Windows : 0)
+              << std::endl;
+    std::cout << "candidates_only_fast: " << errors.OnlyFast << std::endl;
+    std::cout << "candidates_only_reference: " << errors.OnlyReference
+              << std::endl;
+    std::cout << "differing_schedules: " << differing << std::endl;
+
+    if (max_edge_error >= 0 && errors.MaxEdge > max_edge_error) {
+        std::cout << "ERR: Window edges differ by up to " << errors.MaxEdge
+                  << " minutes" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (max_differing >= 0 && differing > max_differing) {
+        std::cout << "ERR: " << differing
+                  << " of the schedules may differ" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,360 @@
+#include <absl/base/log_severity.h>
+#include <absl/log/globals.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "argh.h"
+
+extern "C" {
+#include "include/libastro.h"
+}
+
+#include "input.cc"
+#include "model/object.cc"
+#include "model/synthetic.cc"
+#include "model/telescope.cc"
+#include "schedule.cc"
+
+// Fixed corpus of generated nights, compared against a baseline recorded on
+// the same machine. Every instance runs in a child process of its own, so
+// its peak RSS is not inflated by the ones before it.
+struct Instance {
+    const char *Name;
+    int Objects;
+    int Telescopes;
+    Synthetic::Sky Sky;
+    uint64_t Seed;
+};
+
+const Instance CORPUS[] = {
+    {"uniform_100x1", 100, 1, Synthetic::UNIFORM, 1},
+    {"uniform_500x1", 500, 1, Synthetic::UNIFORM, 2},
+    {"galactic_1000x2", 1000, 2, Synthetic::GALACTIC, 3},
+    {"clustered_1000x2", 1000, 2, Synthetic::CLUSTERED, 4},
+    {"uniform_2000x4", 2000, 4, Synthetic::UNIFORM, 5},
+};
+
+struct Measure {
+    double WallTime = 0;
+    long PeakRss = 0;
+    double Objective = 0;
+    double Gap = 0;
+    std::string Status;
+};
+
+// Largest regressions tolerated: relative for time, memory and objective,
+// absolute for the gap
+struct Tolerances {
+    double Time = 0.25;
+    double Memory = 0.25;
+    double Objective = 0.01;
+    double Gap = 0.01;
+};
+
+void print_help() {
+    std::cout << "Usage scheduler_perf_check:" << std::endl;
+    std::cout << "  scheduler_perf_check [options]" << std::endl;
+    std::cout << "" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --baseline <file>               Compare against a baseline"
+              << std::endl;
+    std::cout << "  --write-baseline <file>         Record a baseline"
+              << std::endl;
+    std::cout << "  --repetitions <count>           Runs per instance, 3 by "
+                 "default"
+              << std::endl;
+    std::cout << "  --time-tolerance <fraction>     0.25 by default"
+              << std::endl;
+    std::cout << "  --memory-tolerance <fraction>   0.25 by default"
+              << std::endl;
+    std::cout << "  --objective-tolerance <fraction>" << std::endl;
+    std::cout << "                                  0.01 by default"
+              << std::endl;
+    std::cout << "  --gap-tolerance <gap>           0.01 by default"
+              << std::endl;
+    std::cout << "  -h, --help                      Show this help"
+              << std::endl;
+}
+
+double Night() {
+    double mjd;
+    cal_mjd(3, 15, 2024, &mjd);
+
+    return mjd + 18 / 24.;
+}
+
+bool Prepare(const Instance &instance, std::vector<Telescope> &telescopes,
+             std::vector<Object> &objects) {
+    auto directory = std::filesystem::temp_directory_path() /
+                     ("scheduler_perf_" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+
+    std::vector<Resource> resources;
+    for (int t = 0; t < instance.Telescopes; t++) {
+        auto path = directory / ("site_" + std::to_string(t + 1) + ".ini");
+        std::ofstream(path, std::ios::trunc)
+            << Synthetic::TelescopeConfig(t, instance.Telescopes);
+        if (!ReadTelescope(path, t + 1, telescopes, resources)) {
+            return false;
+        }
+    }
+    std::filesystem::remove_all(directory);
+
+    Synthetic synthetic(instance.Seed, instance.Sky);
+    for (int i = 0; i < instance.Objects; i++) {
+        objects.push_back(synthetic.Next(i + 1));
+    }
+
+    return true;
+}
+
+// Schedules the instance in a child process, the schedule is discarded
+bool Run(const Instance &instance, Measure &measure) {
+    std::vector<Telescope> telescopes;
+    std::vector<Object> objects;
+    if (!Prepare(instance, telescopes, objects)) {
+        return false;
+    }
+
+    int channel[2];
+    if (pipe(channel) != 0) {
+        return false;
+    }
+
+    std::cout.flush();
+    pid_t child = fork();
+    if (child < 0) {
+        return false;
+    }
+
+    if (child == 0) {
+        close(channel[0]);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+
+        auto begin = std::chrono::steady_clock::now();
+        SolverTelemetry telemetry =
+            Schedule(Night(), telescopes, objects, {}, {""}, {}, "");
+        auto end = std::chrono::steady_clock::now();
+
+        struct rusage usage {};
+        getrusage(RUSAGE_SELF, &usage);
+
+        char result[256];
+        int length = snprintf(
+            result, sizeof(result), "%.17g %ld %.17g %.17g %s",
+            std::chrono::duration<double>(end - begin).count(),
+            usage.ru_maxrss, telemetry.GetObjective(), telemetry.GetGap(),
+            telemetry.GetStatusName().c_str());
+        bool written = write(channel[1], result, length) == length;
+        _exit(written ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(channel[1]);
+    std::string result;
+    char buffer[256];
+    ssize_t length;
+    while ((length = read(channel[0], buffer, sizeof(buffer))) > 0) {
+        result.append(buffer, length);
+    }
+    close(channel[0]);
+
+    int status;
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        return false;
+    }
+
+    std::istringstream line(result);
+    return (bool)(line >> measure.WallTime >> measure.PeakRss >>
+                  measure.Objective >> measure.Gap >> measure.Status);
+}
+
+// Lines of `name wall_seconds peak_rss_kb objective gap`, # starts a comment
+bool ReadBaseline(const std::string &path,
+                  std::map<std::string, Measure> &baseline) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string buf;
+    while (std::getline(file, buf)) {
+        buf = buf.substr(0, buf.find('#'));
+        std::istringstream line(buf);
+        std::string name;
+        Measure measure;
+        if (!(line >> name)) {
+            continue;
+        }
+        if (!(line >> measure.WallTime >> measure.PeakRss >>
+              measure.Objective >> measure.Gap)) {
+            std::cout << "ERR: Baseline entry '" << name << "' was not valid"
+                      << std::endl;
+            return false;
+        }
+
+        baseline[name] = measure;
+    }
+
+    return true;
+}
+
+bool WriteBaseline(const std::string &path,
+                   const std::vector<std::pair<std::string, Measure>> &runs) {
+    std::ofstream file(path, std::ios::trunc);
+    file << "# scheduler_perf_check baseline" << std::endl;
+    file << "# name wall_seconds peak_rss_kb objective gap" << std::endl;
+    for (const auto &run : runs) {
+        file << run.first << " " << std::setprecision(6)
+             << run.second.WallTime << " " << run.second.PeakRss << " "
+             << std::setprecision(12) << run.second.Objective << " "
+             << std::setprecision(6) << run.second.Gap << std::endl;
+    }
+
+    return (bool)file;
+}
+
+// Prints every regression of `measure` over `baseline`
+int Regressions(const std::string &name, const Measure &measure,
+                const Measure &baseline, const Tolerances &tolerances) {
+    int regressions = 0;
+    auto check = [&](const char *what, double value, double reference,
+                     double allowed) {
+        if (value > allowed) {
+            std::cout << "REGRESSION: " << name << " " << what << " "
+                      << value << " over baseline " << reference << std::endl;
+            regressions++;
+        }
+    };
+
+    check("wall time", measure.WallTime, baseline.WallTime,
+          baseline.WallTime * (1 + tolerances.Time));
+    check("peak RSS", measure.PeakRss, baseline.PeakRss,
+          baseline.PeakRss * (1 + tolerances.Memory));
+    // The objective is minimised
+    check("objective", measure.Objective, baseline.Objective,
+          baseline.Objective +
+              tolerances.Objective * std::max(1.0, fabs(baseline.Objective)));
+    check("gap", measure.Gap, baseline.Gap, baseline.Gap + tolerances.Gap);
+
+    return regressions;
+}
+
+int main(int argc, char *argv[]) {
+    argh::parser cmdl(argc, argv, argh::parser::PREFER_PARAM_FOR_UNREG_OPTION);
+
+    if (cmdl[{"-h", "--help"}]) {
+        print_help();
+        return EXIT_SUCCESS;
+    }
+
+    absl::SetMinLogLevel(absl::LogSeverityAtLeast::kWarning);
+
+    int repetitions = 3;
+    if (cmdl({"--repetitions"}) &&
+        (!(cmdl({"--repetitions"}) >> repetitions) || repetitions < 1)) {
+        std::cout << "ERR: Repetitions were not valid" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Tolerances tolerances;
+    std::pair<const char *, double *> options[] = {
+        {"--time-tolerance", &tolerances.Time},
+        {"--memory-tolerance", &tolerances.Memory},
+        {"--objective-tolerance", &tolerances.Objective},
+        {"--gap-tolerance", &tolerances.Gap},
+    };
+    for (auto &option : options) {
+        if (cmdl({option.first}) &&
+            (!(cmdl({option.first}) >> *option.second) ||
+             *option.second < 0)) {
+            std::cout << "ERR: Option " << option.first << " was not valid"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::map<std::string, Measure> baseline;
+    std::string baseline_file = cmdl({"--baseline"}).str();
+    if (!baseline_file.empty() && !ReadBaseline(baseline_file, baseline)) {
+        std::cout << "ERR: Baseline '" << baseline_file
+                  << "' could not be read" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The fastest run is the least disturbed one, memory is the largest
+    std::vector<std::pair<std::string, Measure>> runs;
+    int regressions = 0;
+    for (const Instance &instance : CORPUS) {
+        Measure best;
+        for (int r = 0; r < repetitions; r++) {
+            Measure measure;
+            if (!Run(instance, measure)) {
+                std::cout << "ERR: Instance " << instance.Name
+                          << " could not be scheduled" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            long peak = std::max(best.PeakRss, measure.PeakRss);
+            if (r == 0 || measure.WallTime < best.WallTime) {
+                best = measure;
+            }
+            best.PeakRss = peak;
+        }
+
+        std::cout << std::left << std::setw(20) << instance.Name
+                  << " time " << best.WallTime << " s, peak " << best.PeakRss
+                  << " KiB, objective " << best.Objective << ", gap "
+                  << best.Gap << ", " << best.Status << std::endl;
+
+        // An instance without a baseline is not checked, so it fails
+        auto reference = baseline.find(instance.Name);
+        if (reference != baseline.end()) {
+            regressions += Regressions(instance.Name, best, reference->second,
+                                       tolerances);
+        } else if (!baseline_file.empty()) {
+            std::cout << "MISSING: " << instance.Name
+                      << " has no baseline, record one with --write-baseline"
+                      << std::endl;
+            regressions++;
+        }
+
+        runs.push_back({instance.Name, best});
+    }
+
+    std::string write_file = cmdl({"--write-baseline"}).str();
+    if (!write_file.empty()) {
+        if (!WriteBaseline(write_file, runs)) {
+            std::cout << "ERR: Baseline '" << write_file
+                      << "' could not be written" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "Baseline written to: " << write_file << std::endl;
+    }
+
+    if (regressions > 0) {
+        std::cout << regressions << " regressions or missing baselines"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
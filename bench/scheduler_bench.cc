@@ -0,0 +1,243 @@
+#include <absl/base/log_severity.h>
+#include <absl/log/globals.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "include/libastro.h"
+}
+
+#include "input.cc"
+#include "model/angle.cc"
+#include "model/catalog.cc"
+#include "model/object.cc"
+#include "model/synthetic.cc"
+#include "model/telescope.cc"
+#include "schedule.cc"
+
+// Every benchmark observes the same night from the same site, so results of
+// different releases can be compared
+const double LATITUDE = 37.22;
+const double LONGITUDE = -2.55;
+const int ALTITUDE = 2168;
+const unsigned int SEED = 2024;
+
+double Night() {
+    double mjd;
+    cal_mjd(3, 15, 2024, &mjd);
+
+    return mjd + 18 / 24.;
+}
+
+// Same limits as Synthetic::TelescopeConfig() gives its sites
+Telescope Site() {
+    TelescopeLimits limits{};
+    limits.MinHeight = 30;
+    limits.MinLunarDistance = 20;
+    limits.MinDecNord = std::min(90.0, 90 - LATITUDE - limits.MinHeight);
+    limits.MinDecSouth = std::min(90.0, 90 + LATITUDE - limits.MinHeight);
+    limits.MountHA = 5;
+
+    return Telescope(1, LATITUDE, LONGITUDE, ALTITUDE, "bench", limits);
+}
+
+Now SiteNow() {
+    Now now{};
+    now.n_mjd = Night();
+    now.n_lat = degrad(LATITUDE);
+    now.n_lng = degrad(LONGITUDE);
+    now.n_elev = ALTITUDE / ERAD;
+    now.n_temp = 15;
+    now.n_pressure = 1010;
+    now.n_epoch = J2000;
+
+    return now;
+}
+
+std::vector<Object> SyntheticObjects(int count) {
+    Synthetic synthetic(SEED, Synthetic::UNIFORM);
+    std::vector<Object> objects;
+    for (int i = 0; i < count; i++) {
+        objects.push_back(synthetic.Next(i + 1));
+    }
+
+    return objects;
+}
+
+std::filesystem::path TextCatalog(const std::vector<Object> &objects) {
+    auto path = std::filesystem::temp_directory_path() /
+                ("scheduler_bench_" + std::to_string(objects.size()) + ".dat");
+    std::ofstream file(path, std::ios::trunc);
+    for (const Object &object : objects) {
+        Synthetic::WriteText(file, object);
+    }
+
+    return path;
+}
+
+void BM_Moon(benchmark::State &state) {
+    double mjd = Night();
+    for (auto _ : state) {
+        double lam, bet, rho, msp, mdp;
+        moon(mjd, &lam, &bet, &rho, &msp, &mdp);
+        benchmark::DoNotOptimize(lam);
+        mjd += 1. / (24 * 60);
+    }
+}
+BENCHMARK(BM_Moon);
+
+void BM_NowLst(benchmark::State &state) {
+    Now now = SiteNow();
+    for (auto _ : state) {
+        double lst;
+        now_lst(&now, &lst);
+        benchmark::DoNotOptimize(lst);
+        now.n_mjd += 1. / (24 * 60);
+    }
+}
+BENCHMARK(BM_NowLst);
+
+void BM_TwilightCir(benchmark::State &state) {
+    Now now = SiteNow();
+    for (auto _ : state) {
+        double dawn, dusk;
+        int status;
+        twilight_cir(&now, degrad(-17.5), &dawn, &dusk, &status);
+        benchmark::DoNotOptimize(dusk);
+    }
+}
+BENCHMARK(BM_TwilightCir);
+
+void BM_IsObjectVisible(benchmark::State &state) {
+    Telescope telescope = Site();
+    std::vector<Object> objects = SyntheticObjects(1024);
+    double mjd = Night();
+
+    // Objects rejected by the limits return before the altitude is computed
+    int visible = 0;
+    for (const Object &object : objects) {
+        visible += telescope.IsObjectVisible(mjd, object);
+    }
+    if (visible == 0) {
+        state.SkipWithError("No object is visible from the site");
+        return;
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            telescope.IsObjectVisible(mjd, objects[i++ % objects.size()]));
+    }
+}
+BENCHMARK(BM_IsObjectVisible);
+
+void BM_AngleSeparation(benchmark::State &state) {
+    std::vector<Object> objects = SyntheticObjects(1024);
+    size_t i = 0;
+    for (auto _ : state) {
+        const Object &from = objects[i % objects.size()];
+        const Object &to = objects[(i + 1) % objects.size()];
+        benchmark::DoNotOptimize(
+            Angle::separation(degrad(from.GetDec()), hrrad(from.GetRa()),
+                              degrad(to.GetDec()), hrrad(to.GetRa()))
+                .GetRadians());
+        i++;
+    }
+}
+BENCHMARK(BM_AngleSeparation);
+
+void BM_ReadObjects(benchmark::State &state) {
+    auto path = TextCatalog(SyntheticObjects(state.range(0)));
+    for (auto _ : state) {
+        std::vector<Object> objects;
+        std::vector<std::string> configurations = {""};
+        ReadObjects(path, objects, configurations, {});
+        benchmark::DoNotOptimize(objects.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_ReadObjects)->Arg(1 << 10)->Arg(1 << 14);
+
+void BM_ReadBinary(benchmark::State &state) {
+    auto path = std::filesystem::temp_directory_path() /
+                ("scheduler_bench_" + std::to_string(state.range(0)) + ".bin");
+    Catalog::WriteBinary(path, SyntheticObjects(state.range(0)), {""}, {});
+    for (auto _ : state) {
+        std::vector<Object> objects;
+        std::vector<std::string> configurations;
+        std::vector<std::string> resources;
+        Catalog::ReadBinary(path, objects, configurations, resources);
+        benchmark::DoNotOptimize(objects.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_ReadBinary)->Arg(1 << 10)->Arg(1 << 14);
+
+// Whole pipeline: candidates, model and solve. The report is discarded.
+void BM_Schedule(benchmark::State &state) {
+    std::vector<Telescope> telescopes = {Site()};
+    std::vector<Object> objects = SyntheticObjects(state.range(0));
+    std::ostringstream report;
+    for (auto _ : state) {
+        auto buffer = std::cout.rdbuf(report.rdbuf());
+        SolverTelemetry telemetry =
+            Schedule(Night(), telescopes, objects, {}, {""}, {}, "");
+        std::cout.rdbuf(buffer);
+        report.str("");
+
+        // Without candidates only an empty pipeline would be timed
+        if (telemetry.GetCandidates() == 0) {
+            state.SkipWithError("The night has no candidates");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Schedule)
+    ->Arg(50)
+    ->Arg(200)
+    ->Arg(1000)
+    ->Unit(benchmark::kMillisecond);
+
+// Results are written to scheduler_bench.json as well, unless another
+// output file is given
+int main(int argc, char *argv[]) {
+    absl::SetMinLogLevel(absl::LogSeverityAtLeast::kWarning);
+
+    std::vector<char *> arguments(argv, argv + argc);
+    bool output = false;
+    for (char *argument : arguments) {
+        output |= strncmp(argument, "--benchmark_out=", 16) == 0;
+    }
+
+    std::string file = "--benchmark_out=scheduler_bench.json";
+    std::string format = "--benchmark_out_format=json";
+    if (!output) {
+        arguments.push_back(file.data());
+        arguments.push_back(format.data());
+    }
+
+    int count = arguments.size();
+    benchmark::Initialize(&count, arguments.data());
+    if (benchmark::ReportUnrecognizedArguments(count, arguments.data())) {
+        return EXIT_FAILURE;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return EXIT_SUCCESS;
+}
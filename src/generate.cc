@@ -0,0 +1,152 @@
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "argh.h"
+
+#include "./model/catalog.cc"
+#include "./model/object.cc"
+#include "./model/synthetic.cc"
+
+void print_help() {
+    std::cout << "Usage scheduler_generate:" << std::endl;
+    std::cout << "  scheduler_generate -n <count> [options]" << std::endl;
+    std::cout << "" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -n, --objects <count>           Objects in the catalog"
+              << std::endl;
+    std::cout << "  -s, --seed <seed>               Seed, 1 by default"
+              << std::endl;
+    std::cout << "  --sky <uniform|galactic|clustered>" << std::endl;
+    std::cout << "                                  Sky density, uniform by "
+                 "default"
+              << std::endl;
+    std::cout << "  --text <file>                   Write a text catalog"
+              << std::endl;
+    std::cout << "  --binary <file>                 Write a binary catalog"
+              << std::endl;
+    std::cout << "  --telescopes <count>            Telescope configurations "
+                 "to write"
+              << std::endl;
+    std::cout << "  --telescope-dir <dir>           Directory of the "
+                 "configurations, . by default"
+              << std::endl;
+    std::cout << "  -h, --help                      Show this help"
+              << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    argh::parser cmdl(argc, argv, argh::parser::PREFER_PARAM_FOR_UNREG_OPTION);
+
+    if (cmdl[{"-h", "--help"}]) {
+        print_help();
+        return EXIT_SUCCESS;
+    }
+
+    int64_t count = 0;
+    if (!(cmdl({"-n", "--objects"}) >> count) || count < 0) {
+        print_help();
+
+        std::cout << std::endl;
+        std::cout << "ERR: No valid object count was provided" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint64_t seed = 1;
+    if (cmdl({"-s", "--seed"}) && !(cmdl({"-s", "--seed"}) >> seed)) {
+        std::cout << "ERR: Seed was not valid" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Synthetic::Sky sky = Synthetic::UNIFORM;
+    if (cmdl({"--sky"}) && !Synthetic::ParseSky(cmdl({"--sky"}).str(), sky)) {
+        std::cout << "ERR: Sky '" << cmdl({"--sky"}).str()
+                  << "' is not uniform, galactic or clustered" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string text_file = cmdl({"--text"}).str();
+    std::string binary_file = cmdl({"--binary"}).str();
+
+    int telescopes = 0;
+    if (cmdl({"--telescopes"}) &&
+        (!(cmdl({"--telescopes"}) >> telescopes) || telescopes < 0)) {
+        std::cout << "ERR: Telescope count was not valid" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (text_file.empty() && binary_file.empty() && telescopes == 0) {
+        print_help();
+
+        std::cout << std::endl;
+        std::cout << "ERR: No output was provided" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Text lines are streamed, the binary catalog is sorted by sky index
+    // cell so its objects are kept
+    std::ofstream text;
+    if (!text_file.empty()) {
+        text.open(text_file, std::ios::trunc);
+        if (!text) {
+            std::cout << "ERR: File '" << text_file
+                      << "' could not be written" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    Synthetic synthetic(seed, sky);
+    std::vector<Object> objects;
+    for (int64_t i = 0; i < count; i++) {
+        Object object = synthetic.Next(i + 1);
+        if (text.is_open()) {
+            Synthetic::WriteText(text, object);
+        }
+        if (!binary_file.empty()) {
+            objects.push_back(object);
+        }
+    }
+
+    if (text.is_open()) {
+        std::cout << "Text catalog: " << text_file << std::endl;
+    }
+
+    if (!binary_file.empty()) {
+        if (!Catalog::WriteBinary(binary_file, objects, {""}, {})) {
+            std::cout << "ERR: Binary catalog '" << binary_file
+                      << "' could not be written" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "Binary catalog: " << binary_file << std::endl;
+    }
+
+    std::filesystem::path directory = ".";
+    if (cmdl({"--telescope-dir"})) {
+        directory = cmdl({"--telescope-dir"}).str();
+    }
+
+    std::error_code error;
+    if (telescopes > 0) {
+        std::filesystem::create_directories(directory, error);
+    }
+
+    for (int t = 0; t < telescopes; t++) {
+        auto path = directory / ("site_" + std::to_string(t + 1) + ".ini");
+        std::ofstream config(path, std::ios::trunc);
+        config << Synthetic::TelescopeConfig(t, telescopes);
+        if (!config) {
+            std::cout << "ERR: File '" << path.string()
+                      << "' could not be written" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "Telescope: " << path.string() << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,350 @@
+#ifndef SCHEDULER_INPUT
+#define SCHEDULER_INPUT
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ini.h"
+
+#include "./model/object.cc"
+#include "./model/resource.cc"
+#include "./model/telescope.cc"
+
+std::vector<std::string> split(std::string value, int delimeter) {
+    size_t start = 0;
+    size_t end;
+    std::string item;
+    std::vector<std::string> retVal;
+    while ((end = value.find(delimeter, start)) != std::string::npos) {
+        item = value.substr(start, end - start);
+        retVal.push_back(item);
+
+        start = end + 1;
+    }
+
+    retVal.push_back(value.substr(start));
+
+    return retVal;
+}
+
+// Reads a text catalog: id, RA (h:m:s) and Dec (d:m:s), galactic
+// coordinates and the optional columns described in the man page. New
+// configuration names are appended to `configurations`; resources must be
+// in `resource_names`.
+bool ReadObjects(const std::string &path, std::vector<Object> &objects,
+                 std::vector<std::string> &configurations,
+                 const std::vector<std::string> &resource_names) {
+    std::string buf;
+    std::ifstream ObjectsFile(path);
+    while (std::getline(ObjectsFile, buf)) {
+        auto items = split(buf, ' ');
+        auto id = std::stoi(items.at(0));
+        auto ra_items = split(items.at(1), ':');
+        auto ra = std::stof(ra_items.at(0)) +
+                  std::stof(ra_items.at(1)) / 60 +
+                  std::stof(ra_items.at(2)) / 3600;
+        auto dec_items = split(items.at(2), ':');
+        auto dec = fabs(std::stof(dec_items.at(0))) +
+                   std::stof(dec_items.at(1)) / 60 +
+                   std::stof(dec_items.at(2)) / 3600;
+        if (items.at(2)[0] == '-') {
+            dec = -dec;
+        }
+
+        // Optional instrument configuration after the galactic
+        // coordinates, any name or - for none
+        int configuration = 0;
+        if (items.size() > 6 && !items.at(6).empty() &&
+            items.at(6) != "-") {
+            auto name = std::find(configurations.begin(),
+                                  configurations.end(), items.at(6));
+            configuration = name - configurations.begin();
+            if (name == configurations.end()) {
+                configurations.push_back(items.at(6));
+            }
+        }
+
+        // Optional shared resources held during the observation, as
+        // resource:amount pairs separated by commas
+        std::vector<ResourceDemand> demands;
+        if (items.size() > 7 && !items.at(7).empty() &&
+            items.at(7) != "-") {
+            for (auto pair : split(items.at(7), ',')) {
+                auto fields = split(pair, ':');
+                auto name = fields.at(0);
+                std::transform(name.begin(), name.end(), name.begin(),
+                               ::tolower);
+                auto resource = std::find(resource_names.begin(),
+                                          resource_names.end(), name);
+                if (resource == resource_names.end()) {
+                    std::cout << "ERR: Object " << id << ": resource "
+                              << name << " was not declared" << std::endl;
+                    return false;
+                }
+
+                unsigned int amount =
+                    fields.size() > 1 ? std::stoi(fields.at(1)) : 1;
+                demands.push_back(ResourceDemand{
+                    (int)(resource - resource_names.begin()), amount});
+            }
+        }
+
+        // Optional shortest piece, in minutes, of a splittable object
+        unsigned int min_chunk = 0;
+        if (items.size() > 8 && !items.at(8).empty() &&
+            items.at(8) != "-") {
+            min_chunk = std::stoi(items.at(8));
+        }
+
+        // Optional cadence as visits:min:max, separations in minutes
+        Cadence cadence{1, 0, 0};
+        if (items.size() > 9 && !items.at(9).empty() &&
+            items.at(9) != "-") {
+            auto fields = split(items.at(9), ':');
+            cadence.Visits = std::stoi(fields.at(0));
+            cadence.MinSeparation = std::stoi(fields.at(1));
+            cadence.MaxSeparation =
+                fields.size() > 2 ? std::stoi(fields.at(2))
+                                  : cadence.MinSeparation;
+            if (cadence.Visits == 0 ||
+                cadence.MaxSeparation < cadence.MinSeparation) {
+                std::cout << "ERR: Object " << id
+                          << ": cadence was not valid" << std::endl;
+                return false;
+            }
+        }
+
+        // Optional priority and observation time in minutes, drawn at
+        // random when missing
+        int priority = rand() % 100;
+        if (items.size() > 10 && !items.at(10).empty() &&
+            items.at(10) != "-") {
+            priority = std::stoi(items.at(10));
+        }
+
+        int observation_time = rand() % 60;
+        if (items.size() > 11 && !items.at(11).empty() &&
+            items.at(11) != "-") {
+            observation_time = std::stoi(items.at(11));
+        }
+
+        objects.push_back(Object(id, ra, dec, priority, observation_time, -1,
+                                 configuration)
+                              .WithDemands(demands)
+                              .WithMinChunk(min_chunk)
+                              .WithCadence(cadence));
+    }
+
+    return true;
+}
+
+// Reads one telescope configuration file. Resources declared in it are
+// added to the ones of the site.
+bool ReadTelescope(const std::filesystem::path &path, int id,
+                   std::vector<Telescope> &telescopes,
+                   std::vector<Resource> &resources) {
+    mINI::INIFile file(path);
+    mINI::INIStructure ini;
+    file.read(ini);
+
+    if (!ini.has("observatory")) {
+        std::cout << "ERR: Telesope config: Observatory section was not found"
+                  << std::endl;
+        return false;
+    }
+
+    // read a value
+    if (!ini["observatory"].has("latitude")) {
+        std::cout
+            << "ERR: Telesope config: Observatory: latitude field was not found"
+            << std::endl;
+        return false;
+    }
+
+    double latitude, longitude;
+    int altitude;
+    std::stringstream ini_latitude(ini["observatory"]["latitude"]);
+    if (!(ini_latitude >> latitude)) {
+        std::cout << "ERR: Telescope config: Observatory: Latitude field was "
+                     "not valid"
+                  << std::endl;
+        return false;
+    }
+
+    std::stringstream ini_longitude(ini["observatory"]["longitude"]);
+    if (!(ini_longitude >> longitude)) {
+        std::cout << "ERR: Telescope config: Observatory: Longitude field was "
+                     "not valid"
+                  << std::endl;
+        return false;
+    }
+
+    std::stringstream ini_altitude(ini["observatory"]["altitude"]);
+    if (!(ini_altitude >> altitude)) {
+        std::cout << "ERR: Telescope config: Observatory: Altitude field was "
+                     "not valid"
+                  << std::endl;
+        return false;
+    }
+
+    double min_height, min_lunar_dist, min_dec_N, min_dec_S, mount_HA;
+    std::stringstream ini_limit_min_height(ini["limits"]["min_height"]);
+    if (!(ini_limit_min_height >> min_height)) {
+        std::cout << "ERR: Telescope config: Observatory: Min height field was "
+                     "not valid"
+                  << std::endl;
+        return false;
+    }
+
+    std::stringstream init_limit_min_lunar_dist(
+        ini["limits"]["min_lunar_dist"]);
+    if (!(init_limit_min_lunar_dist >> min_lunar_dist)) {
+        std::cout
+            << "ERR: Telescope config: Observatory: Min lunar dist field was "
+               "not valid"
+            << std::endl;
+        return false;
+    }
+
+    std::stringstream ini_limit_dec_N(ini["limits"]["min_dec_N"]);
+    if (!(ini_limit_dec_N >> min_dec_N)) {
+        std::cout << "ERR: Telescope config: Observatory: Min dec N field was "
+                     "not valid"
+                  << std::endl;
+        return false;
+    }
+
+    std::stringstream ini_limit_min_dec_S(ini["limits"]["min_dec_S"]);
+    if (!(ini_limit_min_dec_S >> min_dec_S)) {
+        std::cout << "ERR: Telescope config: Observatory: Min dec S field was "
+                     "not valid"
+                  << std::endl;
+        return false;
+    }
+
+    std::stringstream ini_limit_mount_ha(ini["limits"]["mount_HA"]);
+    if (!(ini_limit_mount_ha >> mount_HA)) {
+        std::cout << "ERR: Telescope config: Observatory: Min height field was "
+                     "not valid"
+                  << std::endl;
+        return false;
+    }
+
+    // Optional, trails are avoided within half a degree by default
+    double min_satellite_dist = 0.5;
+    if (ini["limits"].has("min_satellite_dist")) {
+        std::stringstream ini_limit_min_satellite_dist(
+            ini["limits"]["min_satellite_dist"]);
+        if (!(ini_limit_min_satellite_dist >> min_satellite_dist)) {
+            std::cout << "ERR: Telescope config: Observatory: Min satellite "
+                         "dist field was not valid"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    // Optional, bright planets are not avoided unless a distance is set
+    double min_planet_dist[3] = {0, 0, 0};
+    const char *planet_fields[3] = {"min_venus_dist", "min_jupiter_dist",
+                                    "min_saturn_dist"};
+    for (int planet = 0; planet < 3; planet++) {
+        if (!ini["limits"].has(planet_fields[planet])) {
+            continue;
+        }
+
+        std::stringstream ini_limit_planet(
+            ini["limits"][planet_fields[planet]]);
+        if (!(ini_limit_planet >> min_planet_dist[planet])) {
+            std::cout << "ERR: Telescope config: Observatory: "
+                      << planet_fields[planet] << " field was not valid"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    // Optional, the altitude limit is only given by min_height when unset
+    double max_airmass = 0;
+    if (ini["limits"].has("max_airmass")) {
+        std::stringstream ini_limit_max_airmass(ini["limits"]["max_airmass"]);
+        if (!(ini_limit_max_airmass >> max_airmass)) {
+            std::cout << "ERR: Telescope config: Observatory: Max airmass "
+                         "field was not valid"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    // Optional, slews are not accounted for unless both speeds are set
+    double mount_speed[4] = {0, 0, 0, 0};
+    const char *mount_fields[4] = {"ra_speed", "dec_speed", "settle_time",
+                                   "setup_time"};
+    for (int field = 0; field < 4; field++) {
+        if (!ini["mount"].has(mount_fields[field])) {
+            continue;
+        }
+
+        std::stringstream ini_mount(ini["mount"][mount_fields[field]]);
+        if (!(ini_mount >> mount_speed[field])) {
+            std::cout << "ERR: Telescope config: Mount: "
+                      << mount_fields[field] << " field was not valid"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    // Optional, resources shared with the other telescopes of the site
+    for (auto const &item : ini["resources"]) {
+        int64_t capacity;
+        std::stringstream ini_resource(item.second);
+        if (!(ini_resource >> capacity) || capacity < 0) {
+            std::cout << "ERR: Telescope config: Resources: " << item.first
+                      << " capacity was not valid" << std::endl;
+            return false;
+        }
+
+        auto declared = std::find_if(
+            resources.begin(), resources.end(),
+            [&](const Resource &resource) { return resource.Name == item.first; });
+        if (declared == resources.end()) {
+            resources.push_back(Resource{item.first, capacity});
+        } else if (declared->Capacity != capacity) {
+            std::cout << "ERR: Telescope config: Resources: " << item.first
+                      << " capacity differs between telescopes" << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "Telescope" << std::endl;
+    telescopes.push_back(Telescope(id, latitude, longitude, altitude,
+                                   path.stem().string(),
+                                   {
+                                       min_height,
+                                       min_lunar_dist,
+                                       min_dec_N,
+                                       min_dec_S,
+                                       mount_HA,
+                                       min_satellite_dist,
+                                       min_planet_dist[0],
+                                       min_planet_dist[1],
+                                       min_planet_dist[2],
+                                       max_airmass,
+                                   },
+                                   {
+                                       mount_speed[0],
+                                       mount_speed[1],
+                                       mount_speed[2],
+                                       mount_speed[3],
+                                   }));
+
+    return true;
+}
+
+#endif
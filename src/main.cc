@@ -2,192 +2,34 @@
 #include <absl/log/globals.h>
 #include <absl/log/log.h>
 #include <algorithm>
-#include <cmath>
 #include <cstdlib>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <ostream>
-#include <sstream>
 #include <stdlib.h>
 #include <time.h>
 
 #include "SchedulerConfig.h"
 
-#include <cstdint>
-#include <map>
 #include <string>
-#include <tuple>
 #include <unistd.h>
 #include <vector>
 
-#include "absl/strings/str_format.h"
 #include "argh.h"
 extern "C" {
 #include "include/libastro.h"
 }
-#include "ini.h"
-
-#include "ortools/sat/cp_model.h"
-#include "ortools/sat/cp_model.pb.h"
-#include "ortools/sat/cp_model_solver.h"
 
+#include "./input.cc"
+#include "./model/catalog.cc"
 #include "./model/object.cc"
+#include "./model/satellites.cc"
+#include "./model/stats.cc"
 #include "./model/telescope.cc"
-
-void Schedule(double julian_date, std::vector<Telescope> telescopes,
-              std::vector<Object> objects) {
-    using namespace operations_research::sat;
-    std::cout << "Implementation of the Scheduder with OR-Tools" << std::endl;
-
-    CpModelBuilder model;
-
-    std::sort(objects.begin(), objects.end());
-
-    std::map<std::tuple<int, int>, IntVar> assigned;
-    std::vector<BoolVar> scheduler;
-    std::vector<IntervalVar> intervals;
-    for (Telescope telescope : telescopes) {
-        Now now;
-        now.n_mjd = julian_date;
-        now.n_lat = telescope.GetLatitude() * PI / 180;
-        now.n_lng = telescope.GetLongitude() * PI / 180;
-        now.n_elev = telescope.GetAltitude();
-        now.n_temp = 15;
-        now.n_dip = now.n_tz = 0;
-        now.n_pressure = 1010;
-        now.n_epoch = J2000;
-
-        double julian_twilight_dawn;
-        double julian_twilight_dusk;
-        int status;
-        twilight_cir(&now, -17.5 * PI / 180, &julian_twilight_dawn,
-                     &julian_twilight_dusk, &status);
-
-        int total_observation_time =
-            trunc((julian_twilight_dusk - julian_twilight_dawn) * 60 * 24);
-
-        std::cout << julian_twilight_dawn << std::endl;
-        std::cout << julian_twilight_dusk << std::endl;
-        std::cout << total_observation_time << std::endl;
-
-        IntVar makespan =
-            model.NewIntVar({0, total_observation_time})
-                .WithName(absl::StrFormat("makespan_%d", telescope.GetId()));
-        std::vector<IntVar> ends;
-        std::vector<BoolVar> restrictions_global;
-        for (Object object : objects) {
-            int visible_start = 0;
-            auto time = julian_twilight_dusk;
-            while (visible_start < total_observation_time &&
-                   !telescope.IsObjectVisible(time, object)) {
-                visible_start++;
-
-                time += ((double)1 / (24 * 60));
-            }
-
-            if (visible_start == total_observation_time) {
-                continue;
-            }
-
-            auto visible_end = visible_start;
-            while (visible_end < total_observation_time &&
-                   telescope.IsObjectVisible(time, object)) {
-                visible_end++;
-
-                time += ((double)1 / (24 * 60));
-            }
-
-            if (visible_end - visible_start < object.GetObservationTime()) {
-                continue;
-            }
-
-            std::cout << "Object added: " << telescope.GetId() << " - "
-                      << object.GetId() << " - " << visible_start << " - "
-                      << visible_end << " - " << object.GetObservationTime()
-                      << std::endl;
-
-            std::string suffix =
-                absl::StrFormat("_%d_%d", object.GetId(), telescope.GetId());
-            IntVar start =
-                model.NewIntVar({visible_start, visible_end})
-                    .WithName(std::string("twilight_start") + suffix);
-            IntVar end = model.NewIntVar({visible_start, visible_end})
-                             .WithName(std::string("object_end") + suffix);
-            IntervalVar interval =
-                model.NewIntervalVar(start, object.GetObservationTime(), end)
-                    .WithName(std::string("object_interval") + suffix);
-            auto key = std::make_tuple(telescope.GetId(), object.GetId());
-            assigned[key] = start;
-            intervals.push_back(interval);
-
-            auto schedule = model.NewBoolVar().WithName(absl::StrFormat(
-                "schedule_%d_%d", telescope.GetId(), object.GetId()));
-            scheduler.push_back(schedule);
-
-            ends.push_back(end);
-        }
-
-        model.AddMaxEquality(makespan, ends);
-        model.Minimize(makespan);
-    }
-
-    model.AddAtMostOne(scheduler);
-    model.AddNoOverlap(intervals);
-
-    const CpSolverResponse response = Solve(model.Build());
-
-    if (response.status() == CpSolverStatus::OPTIMAL ||
-        response.status() == CpSolverStatus::FEASIBLE) {
-        std::cout << "Solution found:" << std::endl;
-
-        std::map<std::tuple<int, int>, int64_t> scheduled;
-        for (auto item : assigned) {
-            auto val = SolutionIntegerValue(response, item.second);
-            scheduled[item.first] = val;
-        }
-
-        for (const auto value : scheduled) {
-            auto job_id = std::get<1>(value.first);
-            auto object = std::find_if(
-                objects.begin(), objects.end(),
-                [&job_id](const Object &obj) { return obj.GetId() == job_id; });
-            std::cout << "Telescope: " << std::get<0>(value.first)
-                      << " Job: " << job_id << " Starts at: " << value.second
-                      << " until "
-                      << value.second + object->GetObservationTime() << " - "
-                      << object->GetObservationTime() << std::endl;
-        }
-
-        std::cout << "Optimal Schedule Length: " << response.objective_value()
-                  << std::endl;
-    } else {
-        std::cout << "No solution was found" << std::endl;
-    }
-
-    // Statistics
-    std::cout << std::endl;
-    std::cout << "Statistics" << std::endl;
-    std::cout << CpSolverResponseStats(response) << std::endl;
-}
-
-std::vector<std::string> split(std::string value, int delimeter) {
-    size_t start = 0;
-    size_t end;
-    std::string item;
-    std::vector<std::string> retVal;
-    while ((end = value.find(delimeter, start)) != std::string::npos) {
-        item = value.substr(start, end - start);
-        retVal.push_back(item);
-
-        start = end + 1;
-    }
-
-    retVal.push_back(value.substr(start));
-
-    return retVal;
-}
+#include "./model/trace.cc"
+#include "./schedule.cc"
 
 void print_help() {
     std::cout << "Usage scheduler:" << std::endl;
@@ -197,11 +39,32 @@ void print_help() {
     std::cout << "" << std::endl;
     std::cout << "Options:" << std::endl;
     std::cout
-        << "  -t, --telescope <file>          Telescope configuration file"
+        << "  -t, --telescope <file>[,...]    Telescope configuration files"
         << std::endl;
     std::cout
         << "  -i, --import-objects <file>     File with objects to schedule"
         << std::endl;
+    std::cout << "  -b, --import-bodies <file>      File with minor planets and "
+                 "comets (XEphem format)"
+              << std::endl;
+    std::cout << "  --satellites <file>             TLE file with satellites "
+                 "to avoid"
+              << std::endl;
+    std::cout << "  --export-objects <file>         Write the objects as a "
+                 "binary catalog"
+              << std::endl;
+    std::cout << "  --cache <dir>                   Directory of cached "
+                 "solutions"
+              << std::endl;
+    std::cout << "  --no-names                      Build the model without "
+                 "variable names"
+              << std::endl;
+    std::cout << "  --stats json                    Write timings and counters "
+                 "to stderr"
+              << std::endl;
+    std::cout << "  --trace <file>                  Write a Chrome trace of "
+                 "the run"
+              << std::endl;
     std::cout << "" << std::endl;
     std::cout << "  --date <date>     Date of the observation (dd/MM/yyyy)"
               << std::endl;
@@ -233,7 +96,7 @@ int main(int argc, char *argv[]) {
         absl::SetMinLogLevel(absl::LogSeverityAtLeast::kWarning);
     }
 
-    std::filesystem::path telescope_config;
+    std::vector<std::filesystem::path> telescope_configs;
     auto telescope_command = cmdl({"-t", "--telescope"});
     if (!telescope_command) {
         print_help();
@@ -242,8 +105,11 @@ int main(int argc, char *argv[]) {
         std::cout << "ERR: No telescope config file was provided" << std::endl;
 
         return EXIT_FAILURE;
-    } else {
-        telescope_config = telescope_command.str();
+    }
+
+    // Several telescopes of one site are separated by commas
+    for (auto item : split(telescope_command.str(), ',')) {
+        std::filesystem::path telescope_config = item;
         if (!std::filesystem::exists(telescope_config)) {
             std::filesystem::path dir;
             if (!std::getenv("SCHEDULER_CONFIG")) {
@@ -262,6 +128,8 @@ int main(int argc, char *argv[]) {
 
             telescope_config = dir;
         }
+
+        telescope_configs.push_back(telescope_config);
     }
 
     std::string objects_file;
@@ -280,103 +148,78 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    mINI::INIFile file(telescope_config);
-    mINI::INIStructure ini;
-    file.read(ini);
-
-    if (!ini.has("observatory")) {
-        std::cout << "ERR: Telesope config: Observatory section was not found"
-                  << std::endl;
-        return EXIT_FAILURE;
+    std::string bodies_file;
+    if (cmdl({"-b", "--import-bodies"})) {
+        bodies_file = cmdl({"-b", "--import-bodies"}).str();
+        if (!std::filesystem::exists(bodies_file)) {
+            std::cout << "File '" << bodies_file << "' does not exists"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
     }
 
-    // read a value
-    if (!ini["observatory"].has("latitude")) {
-        std::cout
-            << "ERR: Telesope config: Observatory: latitude field was not found"
-            << std::endl;
-        return EXIT_FAILURE;
+    // Solutions of previous runs, reused when the model is unchanged
+    std::string cache_directory;
+    if (cmdl({"--cache"})) {
+        cache_directory = cmdl({"--cache"}).str();
     }
 
-    double latitude, longitude;
-    int altitude;
-    std::stringstream ini_latitude(ini["observatory"]["latitude"]);
-    if (!(ini_latitude >> latitude)) {
-        std::cout << "ERR: Telescope config: Observatory: Latitude field was "
-                     "not valid"
-                  << std::endl;
-        return EXIT_FAILURE;
-    }
+    // Names only help to read the model, which production runs never do
+    bool model_names = !cmdl[{"--no-names"}];
 
-    std::stringstream ini_longitude(ini["observatory"]["longitude"]);
-    if (!(ini_longitude >> longitude)) {
-        std::cout << "ERR: Telescope config: Observatory: Longitude field was "
-                     "not valid"
-                  << std::endl;
-        return EXIT_FAILURE;
-    }
+    // Timings and counters of the run, written to stderr
+    bool stats = false;
+    if (cmdl({"--stats"})) {
+        if (cmdl({"--stats"}).str() != "json") {
+            std::cout << "ERR: Statistics format '" << cmdl({"--stats"}).str()
+                      << "' is not json" << std::endl;
+            return EXIT_FAILURE;
+        }
 
-    std::stringstream ini_altitude(ini["observatory"]["altitude"]);
-    if (!(ini_altitude >> altitude)) {
-        std::cout << "ERR: Telescope config: Observatory: Altitude field was "
-                     "not valid"
+#ifndef SCHEDULER_WITH_STATS
+        std::cout << "ERR: Scheduler was built without statistics"
                   << std::endl;
         return EXIT_FAILURE;
-    }
+#endif
 
-    double min_height, min_lunar_dist, min_dec_N, min_dec_S, mount_HA;
-    std::stringstream ini_limit_min_height(ini["limits"]["min_height"]);
-    if (!(ini_limit_min_height >> min_height)) {
-        std::cout << "ERR: Telescope config: Observatory: Min height field was "
-                     "not valid"
-                  << std::endl;
-        return EXIT_FAILURE;
+        Stats::Enable();
+        PerfCounters::Enable();
+        Allocations::Enable();
+        stats = true;
     }
 
-    std::stringstream init_limit_min_lunar_dist(
-        ini["limits"]["min_lunar_dist"]);
-    if (!(init_limit_min_lunar_dist >> min_lunar_dist)) {
-        std::cout
-            << "ERR: Telescope config: Observatory: Min lunar dist field was "
-               "not valid"
-            << std::endl;
+    // Timeline of the run in Chrome trace-event format
+    std::string trace_file;
+    if (cmdl({"--trace"})) {
+#ifndef SCHEDULER_WITH_STATS
+        std::cout << "ERR: Scheduler was built without tracing" << std::endl;
         return EXIT_FAILURE;
-    }
+#endif
 
-    std::stringstream ini_limit_dec_N(ini["limits"]["min_dec_N"]);
-    if (!(ini_limit_dec_N >> min_dec_N)) {
-        std::cout << "ERR: Telescope config: Observatory: Min dec N field was "
-                     "not valid"
-                  << std::endl;
-        return EXIT_FAILURE;
+        trace_file = cmdl({"--trace"}).str();
+        Trace::Enable();
     }
 
-    std::stringstream ini_limit_min_dec_S(ini["limits"]["min_dec_S"]);
-    if (!(ini_limit_min_dec_S >> min_dec_S)) {
-        std::cout << "ERR: Telescope config: Observatory: Min dec S field was "
-                     "not valid"
-                  << std::endl;
-        return EXIT_FAILURE;
+    std::string satellites_file;
+    if (cmdl({"--satellites"})) {
+        satellites_file = cmdl({"--satellites"}).str();
+        if (!std::filesystem::exists(satellites_file)) {
+            std::cout << "File '" << satellites_file << "' does not exists"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
     }
 
-    std::stringstream ini_limit_mount_ha(ini["limits"]["mount_HA"]);
-    if (!(ini_limit_mount_ha >> mount_HA)) {
-        std::cout << "ERR: Telescope config: Observatory: Min height field was "
-                     "not valid"
-                  << std::endl;
-        return EXIT_FAILURE;
+    STATS_TIMER("parse");
+    std::vector<Telescope> telescopes;
+    std::vector<Resource> resources;
+    for (size_t t = 0; t < telescope_configs.size(); t++) {
+        if (!ReadTelescope(telescope_configs[t], t + 1, telescopes,
+                           resources)) {
+            return EXIT_FAILURE;
+        }
     }
 
-    std::cout << "Telescope" << std::endl;
-    auto telescope = Telescope(1, latitude, longitude, altitude, "Test",
-                               {
-                                   min_height,
-                                   min_lunar_dist,
-                                   min_dec_N,
-                                   min_dec_S,
-                                   mount_HA,
-                               });
-
     time_t custom_date{};
     if (cmdl({"-d", "--date"})) {
         auto tmp_date = cmdl({"-d", "--date"}).str();
@@ -403,29 +246,118 @@ int main(int argc, char *argv[]) {
     std::cout << "Julian Date: " << mjdp << std::endl;
 
     std::vector<Object> objects;
-    std::ifstream ObjectsFile(objects_file);
+    std::vector<std::string> configurations = {""};
     std::string buf;
     srand(time(0));
-    const int num_jobs = 5;
-    while (std::getline(ObjectsFile, buf)) {
-        auto items = split(buf, ' ');
-        auto id = std::stoi(items.at(0));
-        auto ra_items = split(items.at(1), ':');
-        auto ra = std::stof(ra_items.at(0)) + std::stof(ra_items.at(1)) / 60 +
-                  std::stof(ra_items.at(2)) / 3600;
-        auto dec_items = split(items.at(2), ':');
-        auto dec = std::stof(dec_items.at(0)) +
-                   std::stof(dec_items.at(1)) / 60 +
-                   std::stof(dec_items.at(2)) / 3600;
-
-        int priority = rand() % 100;
-        objects.push_back(Object(id, ra, dec, priority, rand() % 60));
+    std::vector<std::string> resource_names;
+    for (const Resource &resource : resources) {
+        resource_names.push_back(resource.Name);
     }
 
-    std::vector<Telescope> telescopes;
-    telescopes.push_back(telescope);
+    if (Catalog::IsBinary(objects_file)) {
+        std::vector<std::string> catalog_resources;
+        if (!Catalog::ReadBinary(objects_file, objects, configurations,
+                                 catalog_resources)) {
+            std::cout << "ERR: Binary catalog '" << objects_file
+                      << "' was not valid" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // Resources are stored by name, ids follow the telescope configs
+        for (Object &object : objects) {
+            std::vector<ResourceDemand> demands = object.GetDemands();
+            for (ResourceDemand &demand : demands) {
+                auto name = catalog_resources[demand.Resource];
+                auto resource = std::find(resource_names.begin(),
+                                          resource_names.end(), name);
+                if (resource == resource_names.end()) {
+                    std::cout << "ERR: Object " << object.GetId()
+                              << ": resource " << name << " was not declared"
+                              << std::endl;
+                    return EXIT_FAILURE;
+                }
+
+                demand.Resource = resource - resource_names.begin();
+            }
 
-    Schedule(mjdp, telescopes, objects);
+            if (!demands.empty()) {
+                object = object.WithDemands(demands);
+            }
+        }
+    } else if (!ReadObjects(objects_file, objects, configurations,
+                            resource_names)) {
+        return EXIT_FAILURE;
+    }
+
+    if (cmdl({"--export-objects"})) {
+        auto export_file = cmdl({"--export-objects"}).str();
+        if (!Catalog::WriteBinary(export_file, objects, configurations,
+                                  resource_names)) {
+            std::cout << "ERR: Binary catalog '" << export_file
+                      << "' could not be written" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "Objects exported to: " << export_file << std::endl;
+    }
+
+    if (!bodies_file.empty()) {
+        // Each line is an id followed by an XEphem database line
+        std::ifstream BodiesFile(bodies_file);
+        while (std::getline(BodiesFile, buf)) {
+            auto separator = buf.find(' ');
+            if (separator == std::string::npos) {
+                continue;
+            }
+
+            auto id = std::stoi(buf.substr(0, separator));
+            auto line = buf.substr(separator + 1);
+
+            Obj elements{};
+            char whynot[256];
+            if (db_crack_line(line.data(), &elements, NULL, 0, whynot) < 0) {
+                std::cout << "ERR: Body " << id << " was not valid: " << whynot
+                          << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            if (elements.o_type != ELLIPTICAL &&
+                elements.o_type != HYPERBOLIC &&
+                elements.o_type != PARABOLIC) {
+                std::cout << "ERR: Body " << id
+                          << " is not a minor planet or comet" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            int priority = rand() % 100;
+            objects.push_back(Object(id, elements, priority, rand() % 60));
+        }
+    }
+
+    std::vector<Obj> satellites;
+    if (!satellites_file.empty()) {
+        satellites = SatelliteTracks::Load(satellites_file);
+        std::cout << "Satellites loaded: " << satellites.size() << std::endl;
+    }
+
+    STATS_NEXT("schedule");
+    Schedule(mjdp, telescopes, objects, satellites, configurations, resources,
+             cache_directory, model_names);
+    STATS_STOP();
+
+    if (stats) {
+        std::cerr << Stats::Json() << std::endl;
+    }
+
+    if (!trace_file.empty()) {
+        if (!Trace::Write(trace_file)) {
+            std::cout << "ERR: Trace '" << trace_file
+                      << "' could not be written" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "Trace written to: " << trace_file << std::endl;
+    }
 
     return EXIT_SUCCESS;
 }
@@ -9,6 +9,11 @@ struct TelescopeLimits {
     double MinDecNord;
     double MinDecSouth;
     double MountHA;
+    double MinSatelliteDistance;
+    double MinVenusDistance;
+    double MinJupiterDistance;
+    double MinSaturnDistance;
+    double MaxAirmass;
 };
 
 #endif
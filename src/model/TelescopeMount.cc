@@ -0,0 +1,14 @@
+#ifndef SCHEDULER_TELESCOPE_MOUNT
+#define SCHEDULER_TELESCOPE_MOUNT
+
+// Slew speeds of each axis in degrees per second and settle time in seconds.
+// Slews are ignored when a speed is not set. Changing the instrument
+// configuration takes SetupTime seconds, overlapped with the slew.
+struct TelescopeMount {
+    double RaSpeed;
+    double DecSpeed;
+    double SettleTime;
+    double SetupTime;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef SCHEDULER_AIRMASS
+#define SCHEDULER_AIRMASS
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "./nightgrid.cc"
+#include "./telescope.cc"
+#include "./window.cc"
+extern "C" {
+#include "../include/libastro.h"
+}
+
+// Airmass at mid-exposure as a function of the start minute, compressed into
+// a few linear segments so each candidate adds a handful of constraints to
+// the model instead of one tuple per minute.
+class AirmassCurve {
+  public:
+    // Cost units per unit of airmass above 1
+    static const int64_t SCALE = 100;
+
+    struct Segment {
+        int Start;
+        int End;
+        int64_t CostStart;
+        int64_t CostEnd;
+    };
+
+    AirmassCurve() {}
+
+    // `position(julian_date)` gives the object at any instant; the altitude
+    // comes from the grid's sidereal time, without ephemeris calls
+    template <typename Position>
+    static AirmassCurve Compute(const Telescope &telescope,
+                                const NightGrid &grid, Window window,
+                                int observation_time, Position position,
+                                int max_segments, int64_t tolerance) {
+        AirmassCurve curve;
+        int last_start = window.End - observation_time;
+        if (last_start < window.Start) {
+            return curve;
+        }
+
+        double lat = degrad(telescope.GetLatitude());
+        std::vector<int64_t> costs;
+        for (int start = window.Start; start <= last_start; start++) {
+            int slot = std::min(start + observation_time / 2,
+                                grid.GetSlots() - 1);
+            auto object = position(grid.GetTime(slot));
+            double dec = degrad(object.GetDec());
+            double ha = hrrad(Telescope::HourAngle(grid.GetLst(slot),
+                                                   object.GetRa()));
+            double alt =
+                asin(sin(lat) * sin(dec) + cos(lat) * cos(dec) * cos(ha));
+
+            double x;
+            airmass(alt, &x);
+            costs.push_back(llround((x - 1) * SCALE));
+        }
+
+        curve.Segments.push_back(Segment{window.Start, last_start,
+                                         costs.front(), costs.back()});
+        curve.Compress(costs, window.Start, max_segments, tolerance);
+
+        return curve;
+    }
+
+    const std::vector<Segment> &GetSegments() const { return this->Segments; }
+
+    // Highest cost of any start, 0 for an empty curve
+    int64_t GetMaxCost() const {
+        int64_t max_cost = 0;
+        for (const Segment &segment : this->Segments) {
+            max_cost =
+                std::max({max_cost, segment.CostStart, segment.CostEnd});
+        }
+
+        return max_cost;
+    }
+
+  private:
+    std::vector<Segment> Segments;
+
+    // Douglas-Peucker: split the segment with the largest error at its worst
+    // point until every chord is within `tolerance` or the budget is spent
+    void Compress(const std::vector<int64_t> &costs, int first,
+                  int max_segments, int64_t tolerance) {
+        while ((int)this->Segments.size() < max_segments) {
+            size_t worst_segment = 0;
+            int worst_start = -1;
+            double worst_error = tolerance;
+            for (size_t s = 0; s < this->Segments.size(); s++) {
+                const Segment &segment = this->Segments[s];
+                for (int start = segment.Start + 1; start < segment.End;
+                     start++) {
+                    double error = fabs(costs[start - first] -
+                                        Interpolate(segment, start));
+                    if (error > worst_error) {
+                        worst_error = error;
+                        worst_segment = s;
+                        worst_start = start;
+                    }
+                }
+            }
+
+            if (worst_start < 0) {
+                return;
+            }
+
+            Segment segment = this->Segments[worst_segment];
+            int64_t cost = costs[worst_start - first];
+            this->Segments[worst_segment] =
+                Segment{segment.Start, worst_start, segment.CostStart, cost};
+            this->Segments.insert(
+                this->Segments.begin() + worst_segment + 1,
+                Segment{worst_start, segment.End, cost, segment.CostEnd});
+        }
+    }
+
+    static double Interpolate(const Segment &segment, int start) {
+        if (segment.End == segment.Start) {
+            return segment.CostStart;
+        }
+
+        return segment.CostStart + (double)(segment.CostEnd -
+                                            segment.CostStart) *
+                                       (start - segment.Start) /
+                                       (segment.End - segment.Start);
+    }
+};
+
+#endif
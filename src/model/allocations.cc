@@ -0,0 +1,316 @@
+#ifndef SCHEDULER_ALLOCATIONS
+#define SCHEDULER_ALLOCATIONS
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <malloc.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+// Heap and resident memory of a run, by phase.
+//
+// Built with SCHEDULER_WITH_ALLOCATIONS, global operator new and delete are
+// replaced to count every allocation of every thread; otherwise only the
+// resident set and the allocator's own figures are sampled. Stats::Timer
+// samples them around every phase. Counts include the allocations of every
+// thread while the phase runs, such as the solver's.
+class Allocations {
+  public:
+    struct Sample {
+        int64_t Allocations;
+        int64_t Bytes;
+    };
+
+    static void Enable() { Enabled().store(true); }
+
+    static bool IsEnabled() {
+        return Enabled().load(std::memory_order_relaxed);
+    }
+
+    static bool IsTracked() {
+#ifdef SCHEDULER_WITH_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Called by the replaced operators with the usable size of the block
+    static void Allocated(size_t size) {
+        Counts().Allocations.fetch_add(1, std::memory_order_relaxed);
+        Counts().Bytes.fetch_add(size, std::memory_order_relaxed);
+        int64_t live =
+            Counts().Live.fetch_add(size, std::memory_order_relaxed) + size;
+        int64_t peak = Counts().Peak.load(std::memory_order_relaxed);
+        while (live > peak && !Counts().Peak.compare_exchange_weak(
+                                  peak, live, std::memory_order_relaxed)) {
+        }
+    }
+
+    static void Freed(size_t size) {
+        Counts().Live.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    // Allocations of the whole process so far
+    static bool Read(Sample &sample) {
+        if (!IsEnabled()) {
+            return false;
+        }
+
+        sample.Allocations = Counts().Allocations.load();
+        sample.Bytes = Counts().Bytes.load();
+        return true;
+    }
+
+    // Adds the allocations between two samples to `name`, along with the
+    // resident set when it ends
+    static void Record(const char *name, const Sample &begin,
+                       const Sample &end) {
+        int64_t resident = Resident();
+
+        std::lock_guard<std::mutex> lock(Mutex());
+        Totals *totals = nullptr;
+        for (Totals &phase : Phases()) {
+            if (phase.Name == name) {
+                totals = &phase;
+            }
+        }
+        if (totals == nullptr) {
+            Phases().push_back(Totals{name, 0, 0, 0, 0});
+            totals = &Phases().back();
+        }
+
+        totals->Calls++;
+        totals->Allocations += end.Allocations - begin.Allocations;
+        totals->Bytes += end.Bytes - begin.Bytes;
+        totals->Resident = std::max(totals->Resident, resident);
+    }
+
+    static std::string Json() {
+        std::lock_guard<std::mutex> lock(Mutex());
+        std::ostringstream json;
+        json << "{\"tracked\":" << (IsTracked() ? "true" : "false");
+        if (IsTracked()) {
+            json << ",\"allocations\":" << Counts().Allocations.load()
+                 << ",\"bytes\":" << Counts().Bytes.load()
+                 << ",\"live_bytes\":" << Counts().Live.load()
+                 << ",\"peak_live_bytes\":" << Counts().Peak.load();
+        }
+
+        json << ",\"rss_kb\":" << Resident()
+             << ",\"peak_rss_kb\":" << PeakResident();
+#if defined(__GLIBC__) &&                                                     \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        struct mallinfo2 info = mallinfo2();
+        json << ",\"malloc_arena_bytes\":" << info.arena + info.hblkhd
+             << ",\"malloc_in_use_bytes\":" << info.uordblks + info.hblkhd;
+#endif
+
+        json << ",\"phases\":{";
+        for (size_t i = 0; i < Phases().size(); i++) {
+            const Totals &phase = Phases()[i];
+            json << (i ? "," : "") << "\"" << phase.Name
+                 << "\":{\"calls\":" << phase.Calls;
+            if (IsTracked()) {
+                json << ",\"allocations\":" << phase.Allocations
+                     << ",\"bytes\":" << phase.Bytes;
+            }
+            json << ",\"rss_kb\":" << phase.Resident << "}";
+        }
+        json << "}}";
+
+        return json.str();
+    }
+
+  private:
+    struct Totals {
+        std::string Name;
+        int64_t Calls;
+        int64_t Allocations;
+        int64_t Bytes;
+        int64_t Resident;
+    };
+
+    // Plain atomics, so counting allocates nothing itself
+    struct Counters {
+        std::atomic<int64_t> Allocations{0};
+        std::atomic<int64_t> Bytes{0};
+        std::atomic<int64_t> Live{0};
+        std::atomic<int64_t> Peak{0};
+    };
+
+    static Counters &Counts() {
+        static Counters counters;
+        return counters;
+    }
+
+    // Resident set in KiB, 0 where it is unknown
+    static int64_t Resident() {
+#ifdef __linux__
+        long pages = 0, resident = 0;
+        FILE *file = fopen("/proc/self/statm", "r");
+        if (file != nullptr) {
+            if (fscanf(file, "%ld %ld", &pages, &resident) != 2) {
+                resident = 0;
+            }
+            fclose(file);
+        }
+
+        return (int64_t)resident * sysconf(_SC_PAGESIZE) / 1024;
+#else
+        return 0;
+#endif
+    }
+
+    static int64_t PeakResident() {
+#ifdef __linux__
+        struct rusage usage {};
+        getrusage(RUSAGE_SELF, &usage);
+
+        return usage.ru_maxrss;
+#else
+        return 0;
+#endif
+    }
+
+    static std::atomic<bool> &Enabled() {
+        static std::atomic<bool> enabled(false);
+        return enabled;
+    }
+
+    static std::mutex &Mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::vector<Totals> &Phases() {
+        static std::vector<Totals> phases;
+        return phases;
+    }
+};
+
+// Every binary is a single translation unit, so the replacements are only
+// defined once. Sizes are the allocator's usable sizes, known on both ends
+// even when delete is not given one.
+#ifdef SCHEDULER_WITH_ALLOCATIONS
+void *operator new(size_t size) {
+    void *block = malloc(size ? size : 1);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    Allocations::Allocated(malloc_usable_size(block));
+    return block;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    void *block = malloc(size ? size : 1);
+    if (block != nullptr) {
+        Allocations::Allocated(malloc_usable_size(block));
+    }
+
+    return block;
+}
+
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept {
+    return operator new(size, tag);
+}
+
+// Not inlined, or GCC takes the free() for a mismatched delete
+__attribute__((noinline)) void operator delete(void *block) noexcept {
+    if (block != nullptr) {
+        Allocations::Freed(malloc_usable_size(block));
+        free(block);
+    }
+}
+
+void operator delete[](void *block) noexcept { operator delete(block); }
+
+void operator delete(void *block, size_t) noexcept { operator delete(block); }
+
+void operator delete[](void *block, size_t) noexcept {
+    operator delete(block);
+}
+
+void operator delete(void *block, const std::nothrow_t &) noexcept {
+    operator delete(block);
+}
+
+void operator delete[](void *block, const std::nothrow_t &) noexcept {
+    operator delete(block);
+}
+
+// Over-aligned types. posix_memalign blocks are freed and measured like any
+// other, so the aligned deletes share the plain one.
+void *operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+    void *block = nullptr;
+    if (posix_memalign(&block,
+                       std::max((size_t)alignment, sizeof(void *)),
+                       size ? size : 1) != 0) {
+        return nullptr;
+    }
+
+    Allocations::Allocated(malloc_usable_size(block));
+    return block;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &tag) noexcept {
+    return operator new(size, alignment, tag);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    void *block = operator new(size, alignment, std::nothrow);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return block;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void *block, std::align_val_t) noexcept {
+    operator delete(block);
+}
+
+void operator delete[](void *block, std::align_val_t) noexcept {
+    operator delete(block);
+}
+
+void operator delete(void *block, size_t, std::align_val_t) noexcept {
+    operator delete(block);
+}
+
+void operator delete[](void *block, size_t, std::align_val_t) noexcept {
+    operator delete(block);
+}
+
+void operator delete(void *block, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+    operator delete(block);
+}
+
+void operator delete[](void *block, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+    operator delete(block);
+}
+#endif
+
+#endif
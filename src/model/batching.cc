@@ -0,0 +1,100 @@
+#ifndef SCHEDULER_BATCHING
+#define SCHEDULER_BATCHING
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "./candidate.cc"
+#include "./object.cc"
+#include "./slew.cc"
+#include "./telescope.cc"
+#include "./window.cc"
+
+// Candidates of one instrument configuration whose windows chain together,
+// so they can be observed in a row without changing the setup
+struct Block {
+    int Configuration;
+    Window Span;
+    std::vector<int> Members;
+};
+
+// Clusters the candidates of one telescope into blocks, sorted by the start
+// of their span. Members are kept in window start order.
+inline std::vector<Block> ConfigurationBlocks(
+    const std::vector<Candidate> &candidates) {
+    std::map<int, std::vector<int>> by_configuration;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        by_configuration[candidates[i].Configuration].push_back(i);
+    }
+
+    std::vector<Block> blocks;
+    for (auto &group : by_configuration) {
+        std::vector<int> &members = group.second;
+        std::sort(members.begin(), members.end(), [&](int a, int b) {
+            return candidates[a].Visible.Start < candidates[b].Visible.Start;
+        });
+
+        for (int i : members) {
+            const Window &window = candidates[i].Visible;
+            if (blocks.empty() || blocks.back().Configuration != group.first ||
+                window.Start >= blocks.back().Span.End) {
+                blocks.push_back(Block{group.first, window, {}});
+            }
+
+            Block &block = blocks.back();
+            block.Span.End = std::max(block.Span.End, window.End);
+            block.Members.push_back(i);
+        }
+    }
+
+    std::stable_sort(blocks.begin(), blocks.end(),
+                     [](const Block &a, const Block &b) {
+                         return a.Span.Start < b.Span.Start;
+                     });
+
+    return blocks;
+}
+
+// Greedy schedule observing each block in a row, the way setups are batched
+// by hand, used as a hint for the solver. Returns the start of every
+// candidate, -1 when it is left out; objects in `taken` were already placed
+// on another telescope and are marked as they are placed here.
+inline std::vector<int> BatchedStarts(const Telescope &telescope,
+                                      const std::vector<Candidate> &candidates,
+                                      const std::vector<Block> &blocks,
+                                      const std::vector<Object> &objects,
+                                      std::vector<bool> &taken) {
+    std::vector<int> starts(candidates.size(), -1);
+    int time = 0;
+    int last = -1;
+    for (const Block &block : blocks) {
+        for (int i : block.Members) {
+            const Candidate &candidate = candidates[i];
+            if (candidate.IsSplit() || taken[candidate.ObjectIndex]) {
+                continue;
+            }
+
+            int start = time;
+            if (last >= 0) {
+                start += TransitionTime(telescope, candidates[last], candidate);
+            }
+            start = std::max(start, candidate.Visible.Start);
+
+            int end =
+                start + objects[candidate.ObjectIndex].GetObservationTime();
+            if (end > candidate.Visible.End) {
+                continue;
+            }
+
+            starts[i] = start;
+            taken[candidate.ObjectIndex] = true;
+            time = end;
+            last = i;
+        }
+    }
+
+    return starts;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef SCHEDULER_CANDIDATE
+#define SCHEDULER_CANDIDATE
+
+#include <vector>
+
+#include "./airmass.cc"
+#include "./window.cc"
+
+// Object that a telescope can observe during one visibility window. RA and
+// Dec are taken at the middle of the window, which is enough for slews.
+//
+// Split and monitored candidates are observed in several intervals placed in
+// any of `Windows`; their `Visible` window spans all of them.
+struct Candidate {
+    int TelescopeIndex;
+    int ObjectIndex;
+    Window Visible;
+    AirmassCurve Airmass;
+    double Ra;
+    double Dec;
+    int Configuration;
+    std::vector<Window> Windows;
+
+    bool IsSplit() const { return !this->Windows.empty(); }
+};
+
+#endif
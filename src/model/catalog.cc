@@ -0,0 +1,246 @@
+#ifndef SCHEDULER_CATALOG
+#define SCHEDULER_CATALOG
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "./object.cc"
+#include "./skyindex.cc"
+
+// Binary object catalog.
+//
+// Header: 8 byte magic, format version, sky index order and object count,
+// followed by the names of the instrument configurations and of the shared
+// resources (count, then length and bytes of each one).
+// Records: id, priority, observation time, RA (hours), Dec (degrees), the
+// sky index cell, the configuration, the resource demands (count, then
+// resource and amount of each one), the minimum chunk length and the cadence
+// (visits, minimum and maximum separation), written in cell order so
+// SkyIndex can load them as is. Version 1 catalogs have no configurations,
+// version 2 no resources, version 3 no chunks and version 4 no cadence.
+class Catalog {
+  public:
+    static bool IsBinary(const std::string &path) {
+        char magic[sizeof(MAGIC)] = {};
+        std::ifstream file(path, std::ios::binary);
+        file.read(magic, sizeof(MAGIC));
+
+        return file && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+    }
+
+    // `configurations` and `resources` receive the names, indexed by the ids
+    // used in the objects
+    static bool ReadBinary(const std::string &path,
+                           std::vector<Object> &objects,
+                           std::vector<std::string> &configurations,
+                           std::vector<std::string> &resources) {
+        std::ifstream file(path, std::ios::binary);
+        char magic[sizeof(MAGIC)];
+        uint32_t version, order;
+        uint64_t count;
+        file.read(magic, sizeof(MAGIC));
+        Read(file, version);
+        Read(file, order);
+        Read(file, count);
+        if (!file || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            version < 1 || version > VERSION) {
+            return false;
+        }
+
+        configurations = {""};
+        if (version >= 2) {
+            if (!ReadNames(file, configurations)) {
+                return false;
+            }
+            if (configurations.empty()) {
+                configurations = {""};
+            }
+        }
+
+        resources.clear();
+        if (version >= 3 && !ReadNames(file, resources)) {
+            return false;
+        }
+
+        // Counts come from the file, so they are checked against its size
+        // before anything is allocated
+        if (count > Remaining(file) / MIN_RECORD) {
+            return false;
+        }
+
+        objects.reserve(objects.size() + count);
+        for (uint64_t i = 0; i < count; i++) {
+            int32_t id;
+            uint32_t priority, observation_time;
+            double ra, dec;
+            int64_t cell;
+            uint32_t configuration = 0;
+            Read(file, id);
+            Read(file, priority);
+            Read(file, observation_time);
+            Read(file, ra);
+            Read(file, dec);
+            Read(file, cell);
+            if (version >= 2) {
+                Read(file, configuration);
+            }
+
+            std::vector<ResourceDemand> demands;
+            uint32_t demand_count = 0;
+            if (version >= 3) {
+                Read(file, demand_count);
+            }
+
+            for (uint32_t d = 0; file && d < demand_count; d++) {
+                uint32_t resource, amount;
+                Read(file, resource);
+                Read(file, amount);
+                if (resource >= resources.size()) {
+                    return false;
+                }
+
+                demands.push_back(ResourceDemand{(int)resource, amount});
+            }
+
+            uint32_t min_chunk = 0;
+            if (version >= 4) {
+                Read(file, min_chunk);
+            }
+
+            Cadence cadence{1, 0, 0};
+            if (version >= 5) {
+                Read(file, cadence.Visits);
+                Read(file, cadence.MinSeparation);
+                Read(file, cadence.MaxSeparation);
+            }
+
+            if (!file || configuration >= configurations.size()) {
+                return false;
+            }
+
+            // Cells of a different order are recomputed by SkyIndex
+            if (order != SkyIndex::ORDER) {
+                cell = -1;
+            }
+
+            objects.push_back(Object(id, ra, dec, priority, observation_time,
+                                     cell, configuration)
+                                  .WithDemands(demands)
+                                  .WithMinChunk(min_chunk)
+                                  .WithCadence(cadence));
+        }
+
+        return true;
+    }
+
+    // Writes the fixed objects; moving ones have no catalog position
+    static bool WriteBinary(const std::string &path,
+                            const std::vector<Object> &objects,
+                            const std::vector<std::string> &configurations,
+                            const std::vector<std::string> &resources) {
+        std::vector<std::pair<int64_t, const Object *>> records;
+        for (const Object &object : objects) {
+            if (!object.IsMoving()) {
+                records.push_back(
+                    {SkyIndex::Cell(object.GetRa(), object.GetDec()), &object});
+            }
+        }
+
+        std::stable_sort(records.begin(), records.end(),
+                         [](const auto &a, const auto &b) {
+                             return a.first < b.first;
+                         });
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(MAGIC, sizeof(MAGIC));
+        Write(file, (uint32_t)VERSION);
+        Write(file, (uint32_t)SkyIndex::ORDER);
+        Write(file, (uint64_t)records.size());
+        WriteNames(file, configurations);
+        WriteNames(file, resources);
+
+        for (auto record : records) {
+            const Object &object = *record.second;
+            Write(file, (int32_t)object.GetId());
+            Write(file, (uint32_t)object.GetPriority());
+            Write(file, (uint32_t)object.GetObservationTime());
+            Write(file, object.GetRa());
+            Write(file, object.GetDec());
+            Write(file, record.first);
+            Write(file, (uint32_t)object.GetConfiguration());
+            Write(file, (uint32_t)object.GetDemands().size());
+            for (ResourceDemand demand : object.GetDemands()) {
+                Write(file, (uint32_t)demand.Resource);
+                Write(file, (uint32_t)demand.Amount);
+            }
+            Write(file, (uint32_t)object.GetMinChunk());
+            Write(file, (uint32_t)object.GetCadence().Visits);
+            Write(file, (uint32_t)object.GetCadence().MinSeparation);
+            Write(file, (uint32_t)object.GetCadence().MaxSeparation);
+        }
+
+        return (bool)file;
+    }
+
+  private:
+    static constexpr char MAGIC[8] = {'S', 'C', 'H', 'E', 'D', 'C', 'A', 'T'};
+    static const uint32_t VERSION = 5;
+
+    // Bytes of the shortest record, the one of a version 1 catalog
+    static const uint64_t MIN_RECORD = 36;
+
+    template <typename T> static void Read(std::ifstream &file, T &value) {
+        file.read(reinterpret_cast<char *>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static void Write(std::ofstream &file, const T &value) {
+        file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    // Bytes left to read
+    static uint64_t Remaining(std::ifstream &file) {
+        std::streampos position = file.tellg();
+        file.seekg(0, std::ios::end);
+        std::streampos end = file.tellg();
+        file.seekg(position);
+
+        return file && end > position ? (uint64_t)(end - position) : 0;
+    }
+
+    // False when the names run past the end of the file
+    static bool ReadNames(std::ifstream &file,
+                          std::vector<std::string> &names) {
+        uint32_t count = 0;
+        Read(file, count);
+        names.clear();
+        for (uint32_t i = 0; file && i < count; i++) {
+            uint32_t length = 0;
+            Read(file, length);
+            if (!file || length > Remaining(file)) {
+                return false;
+            }
+
+            std::string name(length, '\0');
+            file.read(name.data(), length);
+            names.push_back(name);
+        }
+
+        return (bool)file;
+    }
+
+    static void WriteNames(std::ofstream &file,
+                           const std::vector<std::string> &names) {
+        Write(file, (uint32_t)names.size());
+        for (const std::string &name : names) {
+            Write(file, (uint32_t)name.size());
+            file.write(name.data(), name.size());
+        }
+    }
+};
+
+#endif
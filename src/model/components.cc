@@ -0,0 +1,134 @@
+#ifndef SCHEDULER_COMPONENTS
+#define SCHEDULER_COMPONENTS
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <vector>
+
+#include "./candidate.cc"
+#include "./object.cc"
+#include "./slew.cc"
+#include "./telescope.cc"
+
+// Clusters of candidates of one telescope whose windows chain together, as
+// indices into `candidates` in start order. A cluster can only use the slots
+// its windows span. Windows less than `reach` minutes apart chain as well.
+inline std::vector<std::vector<int>>
+WindowClusters(const std::vector<Candidate> &candidates, int reach = 0) {
+    std::vector<int> order(candidates.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const Window &first = candidates[a].Visible;
+        const Window &second = candidates[b].Visible;
+        return first.Start < second.Start ||
+               (first.Start == second.Start && first.End > second.End);
+    });
+
+    std::vector<std::vector<int>> clusters;
+    int end = -1;
+    for (int i : order) {
+        if (clusters.empty() || candidates[i].Visible.Start >= end + reach) {
+            clusters.push_back({});
+        }
+
+        clusters.back().push_back(i);
+        end = std::max(end, candidates[i].Visible.End);
+    }
+
+    return clusters;
+}
+
+// Independent parts of the scheduling problem.
+//
+// Two candidates interact when their windows overlap on the same telescope,
+// or lie closer than its longest slew or setup, when they observe the same
+// object, or when their windows overlap and both hold the same shared
+// resource. Overlaps are found with one sweep per
+// telescope and per resource, and joined with a union-find, so components
+// are found in O(n log n). Resource sweeps compare windows after shifting
+// each telescope's by its entry of `origins`, the minutes from a common
+// origin to its dusk. Each component is returned as the indices of its
+// candidates per telescope.
+inline std::vector<std::vector<std::vector<int>>>
+ConflictComponents(const std::vector<std::vector<Candidate>> &candidates,
+                   const std::vector<Telescope> &telescopes,
+                   const std::vector<Object> &objects, int resources,
+                   const std::vector<int> &origins) {
+    std::vector<int> offsets = {0};
+    for (const auto &list : candidates) {
+        offsets.push_back(offsets.back() + list.size());
+    }
+
+    std::vector<int> parent(offsets.back());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](int node) {
+        while (parent[node] != node) {
+            parent[node] = parent[parent[node]];
+            node = parent[node];
+        }
+
+        return node;
+    };
+    auto join = [&](int a, int b) { parent[find(a)] = find(b); };
+
+    std::map<int, int> first_of_object;
+    std::vector<std::vector<Candidate>> holders(resources);
+    std::vector<std::vector<int>> holder_nodes(resources);
+    for (size_t t = 0; t < candidates.size(); t++) {
+        // Transitions are only added within a component
+        for (const auto &cluster : WindowClusters(
+                 candidates[t], MaxTransitionTime(telescopes[t]))) {
+            for (int i : cluster) {
+                join(offsets[t] + i, offsets[t] + cluster.front());
+            }
+        }
+
+        for (size_t i = 0; i < candidates[t].size(); i++) {
+            const Candidate &candidate = candidates[t][i];
+            int node = offsets[t] + i;
+            auto first = first_of_object.emplace(candidate.ObjectIndex, node);
+            join(node, first.first->second);
+
+            Candidate shifted = candidate;
+            shifted.Visible.Start += origins[t];
+            shifted.Visible.End += origins[t];
+            for (ResourceDemand demand :
+                 objects[candidate.ObjectIndex].GetDemands()) {
+                holders[demand.Resource].push_back(shifted);
+                holder_nodes[demand.Resource].push_back(node);
+            }
+        }
+    }
+
+    for (int r = 0; r < resources; r++) {
+        for (const auto &cluster : WindowClusters(holders[r])) {
+            for (int i : cluster) {
+                join(holder_nodes[r][i], holder_nodes[r][cluster.front()]);
+            }
+        }
+    }
+
+    std::map<int, int> component_of_root;
+    std::vector<std::vector<std::vector<int>>> components;
+    for (size_t t = 0; t < candidates.size(); t++) {
+        for (size_t i = 0; i < candidates[t].size(); i++) {
+            int root = find(offsets[t] + i);
+            auto component =
+                component_of_root.emplace(root, components.size());
+            if (component.second) {
+                components.push_back(
+                    std::vector<std::vector<int>>(candidates.size()));
+            }
+
+            components[component.first->second][t].push_back(i);
+        }
+    }
+
+    return components;
+}
+
+#endif
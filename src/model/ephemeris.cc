@@ -0,0 +1,135 @@
+#ifndef SCHEDULER_EPHEMERIS
+#define SCHEDULER_EPHEMERIS
+
+#include <cmath>
+#include <vector>
+extern "C" {
+#include "../include/libastro.h"
+}
+
+// Chebyshev fit of the apparent RA/Dec of a moving body over one night.
+//
+// obj_cir() is evaluated only at the Chebyshev nodes of [start, end]; every
+// other instant is interpolated. RA is unwrapped before fitting so bodies
+// crossing 0h do not break the polynomial.
+class Ephemeris {
+  public:
+    Ephemeris() {
+        this->Start = 0;
+        this->End = 0;
+    }
+
+    static Ephemeris Fit(Now now, Obj body, double start, double end,
+                         int knots) {
+        std::vector<Obj> bodies{body};
+        return FitBatch(now, bodies, start, end, knots).front();
+    }
+
+    // Fits every body in a single pass over the knots. libastro caches the
+    // Sun, nutation and precession per date in static storage, so evaluating
+    // all bodies at one knot before moving to the next keeps those caches
+    // hot; it also means obj_cir() must not be called from several threads.
+    static std::vector<Ephemeris> FitBatch(Now now, std::vector<Obj> bodies,
+                                           double start, double end,
+                                           int knots) {
+        std::vector<Ephemeris> ephemerides(bodies.size());
+        std::vector<std::vector<double>> ra(bodies.size(),
+                                            std::vector<double>(knots));
+        std::vector<std::vector<double>> dec(bodies.size(),
+                                             std::vector<double>(knots));
+
+        // Nodes are visited from the latest to the earliest instant
+        for (int k = 0; k < knots; k++) {
+            now.n_mjd = Time(start, end, Node(k, knots));
+            for (size_t i = 0; i < bodies.size(); i++) {
+                obj_cir(&now, &bodies[i]);
+                ra[i][k] = bodies[i].s_ra;
+                dec[i][k] = bodies[i].s_dec;
+            }
+        }
+
+        for (size_t i = 0; i < bodies.size(); i++) {
+            for (int k = 1; k < knots; k++) {
+                ra[i][k] -= 2 * PI * round((ra[i][k] - ra[i][k - 1]) / (2 * PI));
+            }
+
+            ephemerides[i].Start = start;
+            ephemerides[i].End = end;
+            ephemerides[i].RaCoefficients = Coefficients(ra[i]);
+            ephemerides[i].DecCoefficients = Coefficients(dec[i]);
+        }
+
+        return ephemerides;
+    }
+
+    double GetStart() const { return this->Start; }
+
+    double GetEnd() const { return this->End; }
+
+    // Right ascension in hours, as used by Object
+    double GetRa(double julian_date) const {
+        double ra = Evaluate(this->RaCoefficients, julian_date);
+        range(&ra, 2 * PI);
+
+        return radhr(ra);
+    }
+
+    // Declination in degrees, as used by Object
+    double GetDec(double julian_date) const {
+        return raddeg(Evaluate(this->DecCoefficients, julian_date));
+    }
+
+  private:
+    double Start;
+    double End;
+    std::vector<double> RaCoefficients;
+    std::vector<double> DecCoefficients;
+
+    static double Node(int k, int knots) {
+        return cos(PI * (k + 0.5) / knots);
+    }
+
+    static double Time(double start, double end, double x) {
+        return (start + end) / 2 + (end - start) / 2 * x;
+    }
+
+    static std::vector<double> Coefficients(const std::vector<double> &values) {
+        int knots = values.size();
+        std::vector<double> coefficients(knots, 0.0);
+        for (int j = 0; j < knots; j++) {
+            for (int k = 0; k < knots; k++) {
+                coefficients[j] +=
+                    values[k] * cos(PI * j * (k + 0.5) / knots);
+            }
+
+            coefficients[j] *= 2.0 / knots;
+        }
+
+        return coefficients;
+    }
+
+    // Clenshaw recurrence; instants outside the fit are clamped to its ends
+    double Evaluate(const std::vector<double> &coefficients,
+                    double julian_date) const {
+        if (coefficients.empty()) {
+            return 0;
+        }
+
+        double x = this->End > this->Start
+                       ? (2 * julian_date - this->Start - this->End) /
+                             (this->End - this->Start)
+                       : 0;
+        x = std::fmax(-1.0, std::fmin(1.0, x));
+
+        double b1 = 0, b2 = 0;
+        for (size_t j = coefficients.size() - 1; j > 0; j--) {
+            double b0 = 2 * x * b1 - b2 + coefficients[j];
+            b2 = b1;
+            b1 = b0;
+        }
+
+        return x * b1 - b2 + coefficients[0] / 2;
+    }
+};
+
+#endif
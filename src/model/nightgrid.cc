@@ -0,0 +1,118 @@
+#ifndef SCHEDULER_NIGHT_GRID
+#define SCHEDULER_NIGHT_GRID
+
+#include <map>
+#include <vector>
+
+#include "./stats.cc"
+extern "C" {
+#include "../include/libastro.h"
+}
+
+// Quantities shared by every object of a night, computed once per minute
+// slot from dusk instead of once per object and slot.
+class NightGrid {
+  public:
+    // VSOP87 relative precision used for planets, about 2 arcseconds
+    static constexpr double PLANET_PRECISION = 1e-5;
+
+    NightGrid(double julian_dusk, int slots, double longitude,
+              std::vector<PLCode> planets = {}) {
+        this->Dusk = julian_dusk;
+        this->Slots = slots;
+
+        Now now{};
+        now.n_lng = degrad(longitude);
+        now.n_epoch = J2000;
+        STATS_COUNT(LST_CALLS, slots);
+        for (int slot = 0; slot < slots; slot++) {
+            double lst;
+            now.n_mjd = this->GetTime(slot);
+            now_lst(&now, &lst);
+            this->Lst.push_back(lst);
+
+            double ra, dec;
+            Moon(this->GetTime(slot), &ra, &dec);
+            this->MoonRa.push_back(ra);
+            this->MoonDec.push_back(dec);
+
+            for (PLCode planet : planets) {
+                Planet(this->GetTime(slot), planet, PLANET_PRECISION, &ra,
+                       &dec);
+                this->PlanetRa[planet].push_back(ra);
+                this->PlanetDec[planet].push_back(dec);
+            }
+        }
+    }
+
+    // Geocentric J2000 position of the Moon, RA in hours and Dec in degrees
+    static void Moon(double julian_date, double *ra, double *dec) {
+        double lam, bet, rho, msp, mdp;
+        STATS_COUNT(MOON_CALLS, 1);
+        moon(julian_date, &lam, &bet, &rho, &msp, &mdp);
+        ecl_eq(julian_date, bet, lam, ra, dec);
+        precess(julian_date, J2000, ra, dec);
+
+        range(ra, 2 * PI);
+        *ra = radhr(*ra);
+        *dec = raddeg(*dec);
+    }
+
+    // Geocentric J2000 position of a planet from truncated VSOP87 series.
+    // plans() always asks for full precision, while avoidance radii of a
+    // few degrees only need a few hundred terms per planet. Light time is
+    // ignored, it moves the planets by less than a few arcseconds.
+    static void Planet(double julian_date, PLCode planet, double precision,
+                       double *ra, double *dec) {
+        double earth[6], body[6];
+        vsop87(julian_date, SUN, precision, earth);
+        vsop87(julian_date, planet, precision, body);
+
+        double xe, ye, ze, xp, yp, zp;
+        sphcart(earth[0], earth[1], earth[2], &xe, &ye, &ze);
+        sphcart(body[0], body[1], body[2], &xp, &yp, &zp);
+
+        double lam, bet, rho;
+        cartsph(xp - xe, yp - ye, zp - ze, &lam, &bet, &rho);
+        ecl_eq(julian_date, bet, lam, ra, dec);
+        precess(julian_date, J2000, ra, dec);
+
+        range(ra, 2 * PI);
+        *ra = radhr(*ra);
+        *dec = raddeg(*dec);
+    }
+
+    double GetDusk() const { return this->Dusk; }
+
+    int GetSlots() const { return this->Slots; }
+
+    double GetTime(int slot) const {
+        return this->Dusk + (double)slot / (24 * 60);
+    }
+
+    // Local apparent sidereal time in hours
+    double GetLst(int slot) const { return this->Lst[slot]; }
+
+    double GetMoonRa(int slot) const { return this->MoonRa[slot]; }
+
+    double GetMoonDec(int slot) const { return this->MoonDec[slot]; }
+
+    double GetPlanetRa(PLCode planet, int slot) const {
+        return this->PlanetRa.at(planet)[slot];
+    }
+
+    double GetPlanetDec(PLCode planet, int slot) const {
+        return this->PlanetDec.at(planet)[slot];
+    }
+
+  private:
+    double Dusk;
+    int Slots;
+    std::vector<double> Lst;
+    std::vector<double> MoonRa;
+    std::vector<double> MoonDec;
+    std::map<PLCode, std::vector<double>> PlanetRa;
+    std::map<PLCode, std::vector<double>> PlanetDec;
+};
+
+#endif
@@ -1,16 +1,65 @@
 #ifndef SCHEDULER_OBJECT
 #define SCHEDULER_OBJECT
 
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <vector>
+
+#include "./resource.cc"
+
+// Repeated visits of a monitored object, with the separation in minutes
+// between the starts of consecutive visits
+struct Cadence {
+    unsigned int Visits;
+    unsigned int MinSeparation;
+    unsigned int MaxSeparation;
+};
+extern "C" {
+#include "../include/libastro.h"
+}
+
+// Where an object is at one instant, RA in hours and Dec in degrees. Cheap
+// to copy, unlike the object itself.
+struct SkyPosition {
+    double Ra;
+    double Dec;
+
+    double GetRa() const { return this->Ra; }
+
+    double GetDec() const { return this->Dec; }
+};
+
 class Object {
   public:
     Object(int id, double ra, double dec, unsigned int priority,
-           unsigned int observationTime) {
+           unsigned int observationTime, int64_t cell = -1,
+           int configuration = 0) {
         this->Id = id;
         this->Ra = ra;
         this->Dec = dec;
         this->Priority = priority;
         this->ObservationTime = observationTime;
+        this->Cell = cell;
+        this->Configuration = configuration;
+        this->MinChunk = 0;
+        this->Monitoring = Cadence{1, 0, 0};
+    }
+
+    // Moving body (minor planet or comet) described by its orbital elements;
+    // its position is only known once an Ephemeris is fitted for the night
+    Object(int id, Obj elements, unsigned int priority,
+           unsigned int observationTime) {
+        this->Id = id;
+        this->Ra = 0;
+        this->Dec = 0;
+        this->Priority = priority;
+        this->ObservationTime = observationTime;
+        this->Cell = -1;
+        this->Configuration = 0;
+        this->MinChunk = 0;
+        this->Monitoring = Cadence{1, 0, 0};
+        this->Elements = std::make_shared<Obj>(elements);
     }
 
     int GetId() const { return this->Id; }
@@ -19,10 +68,72 @@ class Object {
 
     double GetDec() const { return this->Dec; }
 
+    // Stored position, only meaningful for fixed objects
+    SkyPosition GetPosition() const {
+        return SkyPosition{this->Ra, this->Dec};
+    }
+
     unsigned int GetPriority() const { return this->Priority; }
 
     unsigned int GetObservationTime() const { return this->ObservationTime; }
 
+    // Sky index cell stored in binary catalogs, -1 when not known
+    int64_t GetCell() const { return this->Cell; }
+
+    // Instrument configuration (filter, camera mode...) the object needs,
+    // 0 when any configuration will do
+    int GetConfiguration() const { return this->Configuration; }
+
+    bool IsMoving() const { return this->Elements != nullptr; }
+
+    Obj GetElements() const { return *this->Elements; }
+
+    const std::vector<ResourceDemand> &GetDemands() const {
+        static const std::vector<ResourceDemand> none;
+        return this->Demands ? *this->Demands : none;
+    }
+
+    // Shortest piece, in minutes, the observation may be split into; 0 when
+    // it must be observed in one go
+    unsigned int GetMinChunk() const { return this->MinChunk; }
+
+    bool IsSplittable() const {
+        return !this->IsMonitored() && this->MinChunk > 0 &&
+               this->MinChunk < this->ObservationTime;
+    }
+
+    Cadence GetCadence() const { return this->Monitoring; }
+
+    bool IsMonitored() const { return this->Monitoring.Visits > 1; }
+
+    // Copy of the object that may be observed in pieces of at least
+    // `min_chunk` minutes
+    Object WithMinChunk(unsigned int min_chunk) const {
+        Object object = *this;
+        object.MinChunk = min_chunk;
+
+        return object;
+    }
+
+    // Copy of the object observed repeatedly at the given cadence
+    Object WithCadence(Cadence cadence) const {
+        Object object = *this;
+        object.Monitoring = cadence;
+
+        return object;
+    }
+
+    // Copy of the object holding the given shared resources
+    Object WithDemands(std::vector<ResourceDemand> demands) const {
+        Object object = *this;
+        object.Demands = demands.empty()
+                             ? nullptr
+                             : std::make_shared<const std::vector<ResourceDemand>>(
+                                   std::move(demands));
+
+        return object;
+    }
+
     void Print() const {
         std::cout << "Id: " << this->Id << std::endl
                   << "RA: " << this->GetRa() << std::endl
@@ -43,6 +154,12 @@ class Object {
     double Dec;
     unsigned int Priority;
     unsigned int ObservationTime;
+    int64_t Cell;
+    int Configuration;
+    unsigned int MinChunk;
+    Cadence Monitoring;
+    std::shared_ptr<Obj> Elements;
+    std::shared_ptr<const std::vector<ResourceDemand>> Demands;
 };
 
 #endif
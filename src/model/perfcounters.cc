@@ -0,0 +1,251 @@
+#ifndef SCHEDULER_PERF_COUNTERS
+#define SCHEDULER_PERF_COUNTERS
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters of the calling thread over named regions, read with
+// perf_event_open(2) as one group so every event covers the same
+// instructions. Stats::Timer samples them around every phase.
+//
+// Containers and locked down kernels often refuse the counters, and virtual
+// machines may only offer some of them: the events that open are reported,
+// and when none do the report says why.
+class PerfCounters {
+  public:
+    enum Event {
+        CYCLES,
+        INSTRUCTIONS,
+        CACHE_MISSES,
+        BRANCH_MISSES,
+        EVENTS
+    };
+
+    // Running totals of the calling thread's events
+    struct Sample {
+        uint64_t Enabled;
+        uint64_t Running;
+        uint64_t Values[EVENTS];
+    };
+
+    static void Enable() { Enabled().store(true); }
+
+    static bool IsEnabled() {
+        return Enabled().load(std::memory_order_relaxed);
+    }
+
+    // Counts of the calling thread so far, false when it has no counters
+    static bool Read(Sample &sample) {
+        return IsEnabled() && Local().Read(sample);
+    }
+
+    // Adds the counts between two samples of the same thread to `name`
+    static void Record(const char *name, const Sample &begin,
+                       const Sample &end) {
+        uint64_t running = end.Running - begin.Running;
+        double scale =
+            running > 0 ? (double)(end.Enabled - begin.Enabled) / running : 0;
+
+        std::lock_guard<std::mutex> lock(Mutex());
+        Totals *totals = nullptr;
+        for (Totals &region : Regions()) {
+            if (region.Name == name) {
+                totals = &region;
+            }
+        }
+        if (totals == nullptr) {
+            Regions().push_back(Totals{name, 0, {}});
+            totals = &Regions().back();
+        }
+
+        totals->Calls++;
+        for (int event = 0; event < EVENTS; event++) {
+            totals->Values[event] +=
+                (uint64_t)((end.Values[event] - begin.Values[event]) * scale);
+        }
+    }
+
+    static std::string Json() {
+        std::lock_guard<std::mutex> lock(Mutex());
+        std::ostringstream json;
+        json << "{\"available\":" << (Available().empty() ? "false" : "true");
+        if (Available().empty()) {
+            json << ",\"reason\":\""
+                 << (Reason().empty() ? "no region ran" : Reason()) << "\"";
+        }
+
+        json << ",\"regions\":{";
+        for (size_t i = 0; i < Regions().size(); i++) {
+            const Totals &region = Regions()[i];
+            json << (i ? "," : "") << "\"" << region.Name
+                 << "\":{\"calls\":" << region.Calls;
+            for (int event : Available()) {
+                json << ",\"" << EventName((Event)event)
+                     << "\":" << region.Values[event];
+            }
+            if (region.Values[CYCLES] > 0 &&
+                IsAvailable(CYCLES) && IsAvailable(INSTRUCTIONS)) {
+                json << ",\"ipc\":"
+                     << (double)region.Values[INSTRUCTIONS] /
+                            region.Values[CYCLES];
+            }
+            json << "}";
+        }
+        json << "}}";
+
+        return json.str();
+    }
+
+  private:
+    struct Totals {
+        std::string Name;
+        int64_t Calls;
+        uint64_t Values[EVENTS];
+    };
+
+    // Events of one thread, the first one that opened leads the group
+    struct Group {
+        int Leader = -1;
+        std::vector<int> Descriptors;
+        std::vector<int> Events;
+
+        Group() {
+#ifdef __linux__
+            const uint64_t configs[EVENTS] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+            int error = 0;
+            for (int event = 0; event < EVENTS; event++) {
+                perf_event_attr attributes;
+                memset(&attributes, 0, sizeof(attributes));
+                attributes.size = sizeof(attributes);
+                attributes.type = PERF_TYPE_HARDWARE;
+                attributes.config = configs[event];
+                attributes.exclude_kernel = 1;
+                attributes.exclude_hv = 1;
+                attributes.read_format = PERF_FORMAT_GROUP |
+                                         PERF_FORMAT_TOTAL_TIME_ENABLED |
+                                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                int descriptor = syscall(SYS_perf_event_open, &attributes, 0,
+                                         -1, this->Leader, 0);
+                if (descriptor < 0) {
+                    error = errno;
+                    continue;
+                }
+
+                if (this->Leader < 0) {
+                    this->Leader = descriptor;
+                }
+                this->Descriptors.push_back(descriptor);
+                this->Events.push_back(event);
+            }
+
+            std::lock_guard<std::mutex> lock(Mutex());
+            if (this->Leader < 0) {
+                Reason() = std::string("perf_event_open: ") + strerror(error);
+            } else if (Available().empty()) {
+                Available() = this->Events;
+            }
+#else
+            std::lock_guard<std::mutex> lock(Mutex());
+            Reason() = "perf_event_open is only available on Linux";
+#endif
+        }
+
+        ~Group() {
+#ifdef __linux__
+            for (int descriptor : this->Descriptors) {
+                close(descriptor);
+            }
+#endif
+        }
+
+        // Counts scaled up when the kernel multiplexed the counters
+        bool Read(Sample &sample) const {
+            if (this->Leader < 0) {
+                return false;
+            }
+
+#ifdef __linux__
+            uint64_t buffer[3 + EVENTS];
+            size_t size = (3 + this->Events.size()) * sizeof(uint64_t);
+            if (read(this->Leader, buffer, size) != (ssize_t)size) {
+                return false;
+            }
+
+            memset(&sample, 0, sizeof(sample));
+            sample.Enabled = buffer[1];
+            sample.Running = buffer[2];
+            for (size_t i = 0; i < this->Events.size(); i++) {
+                sample.Values[this->Events[i]] = buffer[3 + i];
+            }
+
+            return true;
+#else
+            return false;
+#endif
+        }
+    };
+
+    static const char *EventName(Event event) {
+        static const char *names[EVENTS] = {"cycles", "instructions",
+                                            "cache_misses", "branch_misses"};
+
+        return names[event];
+    }
+
+    static bool IsAvailable(Event event) {
+        for (int available : Available()) {
+            if (available == event) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static Group &Local() {
+        thread_local Group group;
+        return group;
+    }
+
+    static std::atomic<bool> &Enabled() {
+        static std::atomic<bool> enabled(false);
+        return enabled;
+    }
+
+    static std::mutex &Mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::vector<int> &Available() {
+        static std::vector<int> available;
+        return available;
+    }
+
+    static std::string &Reason() {
+        static std::string reason;
+        return reason;
+    }
+
+    static std::vector<Totals> &Regions() {
+        static std::vector<Totals> regions;
+        return regions;
+    }
+};
+
+#endif
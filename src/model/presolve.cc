@@ -0,0 +1,135 @@
+#ifndef SCHEDULER_PRESOLVE
+#define SCHEDULER_PRESOLVE
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "./candidate.cc"
+#include "./components.cc"
+#include "./object.cc"
+#include "./telescope.cc"
+
+struct PresolveStats {
+    int Candidates;
+    int Removed;
+    int Clusters;
+    int Saturated;
+};
+
+// Drops candidates that are in no optimal schedule.
+//
+// A candidate A is dominated by a candidate B of the same telescope when B's
+// window contains A's, B has a higher priority and is not longer, and B can
+// not be placed anywhere else. Any schedule observing A without some B
+// improves by observing B in A's place, so A can only be optimal when every
+// B is observed too; when A and the B's do not fit together in the slots
+// their windows span, A is never optimal. Only clusters whose candidates
+// exceed their span (capacity per window cluster) are searched, and only
+// the `neighbours` candidates starting right before A, which keeps the pass
+// linear; any subset of the B's proves the same.
+//
+// Swapping must keep every other constraint, so split, monitored and
+// resource-holding dominators are not used, and telescopes with slew or
+// setup times are left untouched.
+inline PresolveStats
+Presolve(std::vector<std::vector<Candidate>> &candidates,
+         const std::vector<Telescope> &telescopes,
+         const std::vector<Object> &objects, int neighbours) {
+    PresolveStats stats{0, 0, 0, 0};
+
+    std::map<int, int> telescopes_per_object;
+    for (const auto &telescope_candidates : candidates) {
+        for (const Candidate &candidate : telescope_candidates) {
+            telescopes_per_object[candidate.ObjectIndex]++;
+        }
+    }
+
+    for (size_t t = 0; t < candidates.size(); t++) {
+        std::vector<Candidate> &list = candidates[t];
+        stats.Candidates += list.size();
+
+        TelescopeMount mount = telescopes[t].GetMount();
+        bool transitions = (mount.RaSpeed > 0 && mount.DecSpeed > 0) ||
+                           mount.SetupTime > 0;
+
+        auto duration = [&](int i) {
+            return (int)objects[list[i].ObjectIndex].GetObservationTime();
+        };
+        auto priority = [&](int i) {
+            return objects[list[i].ObjectIndex].GetPriority();
+        };
+
+        std::vector<bool> removed(list.size(), false);
+        for (const auto &cluster : WindowClusters(list)) {
+            stats.Clusters++;
+
+            int span_start = list[cluster.front()].Visible.Start;
+            int span_end = span_start;
+            long demand = 0;
+            for (int i : cluster) {
+                span_end = std::max(span_end, list[i].Visible.End);
+                demand += duration(i);
+            }
+
+            if (demand <= span_end - span_start) {
+                continue;
+            }
+
+            stats.Saturated++;
+            if (transitions) {
+                continue;
+            }
+
+            for (size_t a = 0; a < cluster.size(); a++) {
+                int candidate = cluster[a];
+                const Window &window = list[candidate].Visible;
+                if (list[candidate].IsSplit()) {
+                    continue;
+                }
+
+                int hull_start = window.Start;
+                int hull_end = window.End;
+                long total = duration(candidate);
+                int first = std::max(0, (int)a - neighbours);
+                for (int b = a - 1; b >= first; b--) {
+                    int dominator = cluster[b];
+                    const Object &object = objects[list[dominator].ObjectIndex];
+                    if (list[dominator].IsSplit() ||
+                        !object.GetDemands().empty() ||
+                        telescopes_per_object[list[dominator].ObjectIndex] >
+                            1 ||
+                        list[dominator].Visible.End < window.End ||
+                        priority(dominator) <= priority(candidate) ||
+                        duration(dominator) > duration(candidate)) {
+                        continue;
+                    }
+
+                    hull_start =
+                        std::min(hull_start, list[dominator].Visible.Start);
+                    hull_end = std::max(hull_end, list[dominator].Visible.End);
+                    total += duration(dominator);
+                    if (total > hull_end - hull_start) {
+                        removed[candidate] = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        std::vector<Candidate> kept;
+        for (size_t i = 0; i < list.size(); i++) {
+            if (removed[i]) {
+                stats.Removed++;
+            } else {
+                kept.push_back(list[i]);
+            }
+        }
+
+        list = kept;
+    }
+
+    return stats;
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SCHEDULER_RESOURCE
+#define SCHEDULER_RESOURCE
+
+#include <cstdint>
+#include <string>
+
+// Equipment shared by the telescopes of a site (dome, fibre feed, data
+// link...), of which at most Capacity units are in use at any time
+struct Resource {
+    std::string Name;
+    int64_t Capacity;
+};
+
+// Units of a resource, by index in the site's resources, held by an object
+// during its whole observation
+struct ResourceDemand {
+    int Resource;
+    unsigned int Amount;
+};
+
+#endif
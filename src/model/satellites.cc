@@ -0,0 +1,248 @@
+#ifndef SCHEDULER_SATELLITES
+#define SCHEDULER_SATELLITES
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "./window.cc"
+extern "C" {
+#include "../include/libastro.h"
+}
+
+// Sky tracks of every illuminated satellite above the horizon during one
+// night, used to mask the slots in which a trail would cross a field.
+//
+// Each satellite is sampled a few times per slot and consecutive samples
+// form a great-circle segment. Segments are kept as structure of arrays and
+// indexed per slot by one-degree declination bands, so a query only tests
+// the handful of segments close to the field.
+class SatelliteTracks {
+  public:
+    SatelliteTracks() { this->Slots = 0; }
+
+    // Reads a TLE file, with or without a name line before each element set
+    static std::vector<Obj> Load(const std::string &path) {
+        std::vector<Obj> satellites;
+        std::vector<std::string> lines;
+        std::ifstream file(path);
+        std::string buf;
+        while (std::getline(file, buf)) {
+            buf.erase(0, buf.find_first_not_of(" \t"));
+            if (!buf.empty()) {
+                lines.push_back(buf);
+            }
+        }
+
+        size_t i = 0;
+        while (i + 1 < lines.size()) {
+            std::string name;
+            if (lines[i][0] == '1' && lines[i + 1][0] == '2') {
+                name = lines[i].substr(2, 5);
+            } else if (i + 2 < lines.size()) {
+                name = lines[i++];
+            } else {
+                break;
+            }
+
+            Obj satellite{};
+            if (db_tle(name.data(), lines[i].data(), lines[i + 1].data(),
+                       &satellite) == 0) {
+                satellites.push_back(satellite);
+                i += 2;
+            } else {
+                i++;
+            }
+        }
+
+        return satellites;
+    }
+
+    // Propagates all satellites with SGP4/SDP4 over `slots` minutes from
+    // dusk, `samples` times per slot. Every satellite is evaluated at one
+    // instant before moving to the next, which keeps libastro's sidereal time
+    // and nutation caches hot. Without satellites, or without a night, the
+    // tracks are empty.
+    static SatelliteTracks Propagate(Now now, std::vector<Obj> satellites,
+                                     double julian_dusk, int slots,
+                                     int samples) {
+        SatelliteTracks tracks;
+        if (satellites.empty() || slots <= 0) {
+            return tracks;
+        }
+        tracks.Slots = slots;
+
+        size_t count = satellites.size();
+        std::vector<double> x(count), y(count), z(count);
+        std::vector<bool> up(count, false);
+        std::vector<int> slot_of;
+
+        for (int sample = 0; sample <= slots * samples; sample++) {
+            now.n_mjd = julian_dusk + (double)sample / (samples * 24 * 60);
+            int slot = std::min((sample - 1) / samples, slots - 1);
+            for (size_t i = 0; i < count; i++) {
+                bool was_up = up[i];
+                double px = x[i], py = y[i], pz = z[i];
+
+                up[i] = obj_cir(&now, &satellites[i]) == 0 &&
+                        satellites[i].s_alt > 0 && !satellites[i].s_eclipsed;
+                if (!up[i]) {
+                    continue;
+                }
+
+                sphcart(satellites[i].s_ra, satellites[i].s_dec, 1, &x[i],
+                        &y[i], &z[i]);
+                if (sample > 0 && was_up) {
+                    tracks.AddSegment(px, py, pz, x[i], y[i], z[i]);
+                    slot_of.push_back(slot);
+                }
+            }
+        }
+
+        tracks.BuildIndex(slot_of);
+
+        return tracks;
+    }
+
+    bool IsEmpty() const { return this->X0.empty(); }
+
+    // Whether a satellite passes within `radius` degrees of the position
+    // (RA in hours, Dec in degrees) during the slot
+    bool Crosses(int slot, double ra, double dec, double radius) const {
+        if (this->IsEmpty() || slot < 0 || slot >= this->Slots) {
+            return false;
+        }
+
+        double px, py, pz;
+        sphcart(hrrad(ra), degrad(dec), 1, &px, &py, &pz);
+        double limit = degrad(radius);
+
+        int first = Band(dec - radius);
+        int last = Band(dec + radius);
+        for (int band = first; band <= last; band++) {
+            int cell = slot * BANDS + band;
+            for (int k = this->Offsets[cell]; k < this->Offsets[cell + 1];
+                 k++) {
+                if (this->Distance(this->Index[k], px, py, pz) <= limit) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // Clears every visible slot in which `position(julian_date)` is crossed
+    template <typename Position>
+    void Mask(Visibility &visibility, double julian_dusk, double radius,
+              Position position) const {
+        if (this->IsEmpty()) {
+            return;
+        }
+
+        for (int slot = 0; slot < visibility.GetSlots(); slot++) {
+            if (!visibility.Test(slot)) {
+                continue;
+            }
+
+            auto object = position(julian_dusk + (double)slot / (24 * 60));
+            if (this->Crosses(slot, object.GetRa(), object.GetDec(),
+                              radius)) {
+                visibility.Clear(slot);
+            }
+        }
+    }
+
+  private:
+    static const int BANDS = 180;
+
+    int Slots;
+    std::vector<double> X0, Y0, Z0;
+    std::vector<double> X1, Y1, Z1;
+    std::vector<float> DecMin, DecMax;
+    std::vector<int> Offsets;
+    std::vector<int> Index;
+
+    static int Band(double dec) {
+        return std::clamp((int)floor(dec + 90), 0, BANDS - 1);
+    }
+
+    void AddSegment(double x0, double y0, double z0, double x1, double y1,
+                    double z1) {
+        this->X0.push_back(x0);
+        this->Y0.push_back(y0);
+        this->Z0.push_back(z0);
+        this->X1.push_back(x1);
+        this->Y1.push_back(y1);
+        this->Z1.push_back(z1);
+
+        // The arc may bulge past its ends by up to its sagitta
+        double arc = acos(std::clamp(x0 * x1 + y0 * y1 + z0 * z1, -1.0, 1.0));
+        double sagitta = raddeg(arc * arc / 8);
+        double dec0 = raddeg(asin(std::clamp(z0, -1.0, 1.0)));
+        double dec1 = raddeg(asin(std::clamp(z1, -1.0, 1.0)));
+        this->DecMin.push_back(std::min(dec0, dec1) - sagitta);
+        this->DecMax.push_back(std::max(dec0, dec1) + sagitta);
+    }
+
+    // Compressed per (slot, band) lists of segment ids
+    void BuildIndex(const std::vector<int> &slot_of) {
+        this->Offsets =
+            std::vector<int>(std::max(0, this->Slots) * BANDS + 1, 0);
+        for (size_t s = 0; s < slot_of.size(); s++) {
+            for (int band = Band(this->DecMin[s]); band <= Band(this->DecMax[s]);
+                 band++) {
+                this->Offsets[slot_of[s] * BANDS + band + 1]++;
+            }
+        }
+
+        for (size_t cell = 1; cell < this->Offsets.size(); cell++) {
+            this->Offsets[cell] += this->Offsets[cell - 1];
+        }
+
+        std::vector<int> fill(this->Offsets.begin(), this->Offsets.end() - 1);
+        this->Index = std::vector<int>(this->Offsets.back());
+        for (size_t s = 0; s < slot_of.size(); s++) {
+            for (int band = Band(this->DecMin[s]); band <= Band(this->DecMax[s]);
+                 band++) {
+                this->Index[fill[slot_of[s] * BANDS + band]++] = s;
+            }
+        }
+    }
+
+    // Angular distance in radians from a unit vector to segment `s`
+    double Distance(int s, double px, double py, double pz) const {
+        double ax = this->X0[s], ay = this->Y0[s], az = this->Z0[s];
+        double bx = this->X1[s], by = this->Y1[s], bz = this->Z1[s];
+
+        double nx = ay * bz - az * by;
+        double ny = az * bx - ax * bz;
+        double nz = ax * by - ay * bx;
+        double norm = sqrt(nx * nx + ny * ny + nz * nz);
+
+        double to_a = acos(std::clamp(px * ax + py * ay + pz * az, -1.0, 1.0));
+        double to_b = acos(std::clamp(px * bx + py * by + pz * bz, -1.0, 1.0));
+        if (norm < 1e-12) {
+            return std::min(to_a, to_b);
+        }
+
+        nx /= norm;
+        ny /= norm;
+        nz /= norm;
+
+        // Inside the arc when the point lies between both ends
+        double side_a = (ay * pz - az * py) * nx + (az * px - ax * pz) * ny +
+                        (ax * py - ay * px) * nz;
+        double side_b = (py * bz - pz * by) * nx + (pz * bx - px * bz) * ny +
+                        (px * by - py * bx) * nz;
+        if (side_a >= 0 && side_b >= 0) {
+            return asin(std::min(1.0, fabs(px * nx + py * ny + pz * nz)));
+        }
+
+        return std::min(to_a, to_b);
+    }
+};
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef SCHEDULER_SKY_INDEX
+#define SCHEDULER_SKY_INDEX
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "./object.cc"
+extern "C" {
+#include "../include/libastro.h"
+}
+
+// Hierarchical equal-area index of the fixed objects of the catalog.
+//
+// Cells follow the HEALPix nested scheme: the 12 base cells are split in four
+// at every order, and the children of a cell are numbered consecutively, so a
+// cell at any order covers one contiguous range of the leaf ids stored here.
+// Queries descend from the base cells and accept or reject whole ranges at
+// once, only testing individual objects in cells crossing the boundary.
+class SkyIndex {
+  public:
+    // Order of the cells stored in the catalog, about 3.4' wide
+    static const int ORDER = 10;
+
+    SkyIndex() {}
+
+    SkyIndex(const std::vector<Object> &objects) {
+        std::vector<std::pair<int64_t, int>> entries;
+        bool sorted = true;
+        for (size_t i = 0; i < objects.size(); i++) {
+            if (objects[i].IsMoving()) {
+                continue;
+            }
+
+            int64_t cell = objects[i].GetCell();
+            if (cell < 0) {
+                cell = Cell(objects[i].GetRa(), objects[i].GetDec());
+            }
+
+            sorted = sorted && (entries.empty() || entries.back().first <= cell);
+            entries.push_back({cell, i});
+        }
+
+        // Catalogs written by Catalog::WriteBinary are already in cell order
+        if (!sorted) {
+            std::sort(entries.begin(), entries.end());
+        }
+
+        for (auto entry : entries) {
+            const Object &object = objects[entry.second];
+            double x, y, z;
+            sphcart(hrrad(object.GetRa()), degrad(object.GetDec()), 1, &x, &y,
+                    &z);
+
+            this->Cells.push_back(entry.first);
+            this->Positions.push_back(entry.second);
+            this->X.push_back(x);
+            this->Y.push_back(y);
+            this->Z.push_back(z);
+        }
+    }
+
+    // Leaf cell of a position, RA in hours and Dec in degrees
+    static int64_t Cell(double ra, double dec) {
+        return Nest(ORDER, sin(degrad(dec)), hrrad(ra));
+    }
+
+    size_t Size() const { return this->Cells.size(); }
+
+    // Follows the objects to a new order, object `i` of the vector the index
+    // was built from now being at `positions[i]`
+    void Renumber(const std::vector<int> &positions) {
+        for (int &position : this->Positions) {
+            position = positions[position];
+        }
+    }
+
+    // Positions, in the vector the index was built from, of the objects
+    // within `radius` degrees of the given point
+    std::vector<int> Cone(double ra, double dec, double radius) const {
+        std::vector<int> found;
+        double x, y, z;
+        sphcart(hrrad(ra), degrad(dec), 1, &x, &y, &z);
+
+        Query query = {x, y, z, degrad(radius), 0, 0};
+        for (int64_t cell = 0; cell < 12; cell++) {
+            this->Descend(query, 0, cell, found);
+        }
+
+        return found;
+    }
+
+    // Positions of the objects with declination inside [dec_min, dec_max]
+    std::vector<int> Band(double dec_min, double dec_max) const {
+        std::vector<int> found;
+
+        Query query = {0, 0, 0, -1, degrad(dec_min), degrad(dec_max)};
+        for (int64_t cell = 0; cell < 12; cell++) {
+            this->Descend(query, 0, cell, found);
+        }
+
+        return found;
+    }
+
+  private:
+    // Cone when Radius >= 0, declination band otherwise
+    struct Query {
+        double X, Y, Z;
+        double Radius;
+        double DecMin, DecMax;
+    };
+
+    std::vector<int64_t> Cells;
+    std::vector<int> Positions;
+    std::vector<double> X, Y, Z;
+
+    // Upper bound of the distance from a cell center to its corners; cells
+    // reach about 1.05 times the side of a square of the same area
+    static double MaxRadius(int order) {
+        return 1.5 * sqrt(PI / 3) / (1 << order);
+    }
+
+    void Descend(const Query &query, int order, int64_t cell,
+                 std::vector<int> &found) const {
+        int shift = 2 * (ORDER - order);
+        auto first = std::lower_bound(this->Cells.begin(), this->Cells.end(),
+                                      cell << shift) -
+                     this->Cells.begin();
+        auto last = std::lower_bound(this->Cells.begin(), this->Cells.end(),
+                                     (cell + 1) << shift) -
+                    this->Cells.begin();
+        if (first == last) {
+            return;
+        }
+
+        double center_z, phi;
+        Center(order, cell, &center_z, &phi);
+        double radius = MaxRadius(order);
+
+        double low, high;
+        if (query.Radius >= 0) {
+            double x, y, z;
+            sphcart(phi, asin(center_z), 1, &x, &y, &z);
+            double distance = acos(std::clamp(
+                x * query.X + y * query.Y + z * query.Z, -1.0, 1.0));
+            low = distance - radius;
+            high = distance + radius;
+            if (low > query.Radius) {
+                return;
+            }
+
+            if (high <= query.Radius) {
+                found.insert(found.end(), this->Positions.begin() + first,
+                             this->Positions.begin() + last);
+                return;
+            }
+        } else {
+            double dec = asin(center_z);
+            low = dec - radius;
+            high = dec + radius;
+            if (high < query.DecMin || low > query.DecMax) {
+                return;
+            }
+
+            if (low >= query.DecMin && high <= query.DecMax) {
+                found.insert(found.end(), this->Positions.begin() + first,
+                             this->Positions.begin() + last);
+                return;
+            }
+        }
+
+        if (order < ORDER && last - first > 8) {
+            for (int64_t child = cell * 4; child < cell * 4 + 4; child++) {
+                this->Descend(query, order + 1, child, found);
+            }
+
+            return;
+        }
+
+        for (auto i = first; i < last; i++) {
+            if (this->Contains(query, i)) {
+                found.push_back(this->Positions[i]);
+            }
+        }
+    }
+
+    bool Contains(const Query &query, size_t i) const {
+        if (query.Radius >= 0) {
+            double cosine = this->X[i] * query.X + this->Y[i] * query.Y +
+                            this->Z[i] * query.Z;
+            return acos(std::clamp(cosine, -1.0, 1.0)) <= query.Radius;
+        }
+
+        double dec = asin(std::clamp(this->Z[i], -1.0, 1.0));
+        return dec >= query.DecMin && dec <= query.DecMax;
+    }
+
+    static int64_t Spread(int64_t v) {
+        int64_t result = 0;
+        for (int bit = 0; bit < 32; bit++) {
+            result |= ((v >> bit) & 1) << (2 * bit);
+        }
+
+        return result;
+    }
+
+    static int64_t Compress(int64_t v) {
+        int64_t result = 0;
+        for (int bit = 0; bit < 32; bit++) {
+            result |= ((v >> (2 * bit)) & 1) << bit;
+        }
+
+        return result;
+    }
+
+    // HEALPix ang2pix in the nested scheme, z = sin(dec) and phi = RA
+    static int64_t Nest(int order, double z, double phi) {
+        int64_t nside = (int64_t)1 << order;
+        double za = fabs(z);
+        double tt = fmod(phi, 2 * PI);
+        if (tt < 0) {
+            tt += 2 * PI;
+        }
+        tt /= PI / 2;
+
+        int64_t face, ix, iy;
+        if (za <= 2.0 / 3) {
+            double temp1 = nside * (0.5 + tt);
+            double temp2 = nside * (z * 0.75);
+            int64_t jp = (int64_t)(temp1 - temp2);
+            int64_t jm = (int64_t)(temp1 + temp2);
+            int64_t ifp = jp >> order;
+            int64_t ifm = jm >> order;
+            face = ifp == ifm ? (ifp | 4) : (ifp < ifm ? ifp : ifm + 8);
+            ix = jm & (nside - 1);
+            iy = nside - (jp & (nside - 1)) - 1;
+        } else {
+            int64_t ntt = std::min((int64_t)3, (int64_t)tt);
+            double tp = tt - ntt;
+            double tmp = nside * sqrt(3 * (1 - za));
+            int64_t jp = std::min((int64_t)(tp * tmp), nside - 1);
+            int64_t jm = std::min((int64_t)((1.0 - tp) * tmp), nside - 1);
+            if (z >= 0) {
+                face = ntt;
+                ix = nside - jm - 1;
+                iy = nside - jp - 1;
+            } else {
+                face = ntt + 8;
+                ix = jp;
+                iy = jm;
+            }
+        }
+
+        return (face << (2 * order)) + Spread(ix) + (Spread(iy) << 1);
+    }
+
+    // HEALPix pix2ang in the nested scheme
+    static void Center(int order, int64_t cell, double *z, double *phi) {
+        static const int jrll[] = {2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4};
+        static const int jpll[] = {1, 3, 5, 7, 0, 2, 4, 6, 1, 3, 5, 7};
+
+        int64_t nside = (int64_t)1 << order;
+        int64_t npface = nside * nside;
+        int64_t face = cell >> (2 * order);
+        int64_t ipf = cell & (npface - 1);
+        int64_t ix = Compress(ipf);
+        int64_t iy = Compress(ipf >> 1);
+
+        int64_t jr = jrll[face] * nside - ix - iy - 1;
+        int64_t nr, kshift;
+        if (jr < nside) {
+            nr = jr;
+            *z = 1 - (double)(nr * nr) / (3 * npface);
+            kshift = 0;
+        } else if (jr > 3 * nside) {
+            nr = 4 * nside - jr;
+            *z = (double)(nr * nr) / (3 * npface) - 1;
+            kshift = 0;
+        } else {
+            nr = nside;
+            *z = (2 * nside - jr) * 2.0 / (3 * nside);
+            kshift = (jr - nside) & 1;
+        }
+
+        int64_t jp = (jpll[face] * nr + ix - iy + 1 + kshift) / 2;
+        if (jp > 4 * nside) {
+            jp -= 4 * nside;
+        }
+        if (jp < 1) {
+            jp += 4 * nside;
+        }
+
+        *phi = (jp - (kshift + 1) * 0.5) * (PI / 2 / nr);
+    }
+};
+
+#endif
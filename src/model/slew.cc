@@ -0,0 +1,134 @@
+#ifndef SCHEDULER_SLEW
+#define SCHEDULER_SLEW
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <set>
+#include <vector>
+
+#include "./candidate.cc"
+#include "./telescope.cc"
+
+// Slew and setup needed between two candidates of the same telescope, in
+// minutes
+struct Transition {
+    int From;
+    int To;
+    int Time;
+};
+
+// The instrument is reconfigured while the mount slews
+inline int TransitionTime(const Telescope &telescope, const Candidate &from,
+                          const Candidate &to) {
+    return std::max(
+        telescope.GetSlewTime(from.Ra, from.Dec, to.Ra, to.Dec),
+        telescope.GetSetupTime(from.Configuration, to.Configuration));
+}
+
+// Longest transition of the telescope: half a turn on both axes and a
+// configuration change
+inline int MaxTransitionTime(const Telescope &telescope) {
+    return std::max(telescope.GetSlewTime(0, -90, 12, 90),
+                    telescope.GetSetupTime(1, 2));
+}
+
+// Shortest transition between any two candidates: the settle time, as two
+// objects may share a position and a configuration
+inline int MinTransitionTime(const Telescope &telescope) {
+    return telescope.GetSlewTime(0, 0, 0, 0);
+}
+
+// Sparse transition matrix of the candidates of one telescope.
+//
+// Only candidates whose windows overlap, or lie closer than the longest
+// transition, can end up back to back without room for it, so the windows
+// are swept in start order. Each candidate is only compared with the
+// `neighbours` latest starting ones still in reach, and keeps the
+// `neighbours` closest partners, so the sweep and the model stay linear in
+// the number of candidates however long the windows are. Split candidates
+// take part with the span of their windows. Pairs left out are kept apart
+// by the minimum transition only.
+inline std::vector<Transition>
+SlewTransitions(const Telescope &telescope,
+                const std::vector<Candidate> &candidates, int neighbours) {
+    std::vector<Transition> transitions;
+    TelescopeMount mount = telescope.GetMount();
+    bool slews = mount.RaSpeed > 0 && mount.DecSpeed > 0;
+    if ((!slews && mount.SetupTime <= 0) || neighbours <= 0) {
+        return transitions;
+    }
+
+    int max_transition = MaxTransitionTime(telescope);
+    std::vector<int> order;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        order.push_back(i);
+    }
+
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return candidates[a].Visible.Start < candidates[b].Visible.Start;
+    });
+
+    // Per candidate, the largest overlaps seen so far (smallest on top); a
+    // gap counts as a negative overlap
+    typedef std::pair<int, int> Overlap;
+    std::vector<std::priority_queue<Overlap, std::vector<Overlap>,
+                                    std::greater<Overlap>>>
+        best(candidates.size());
+    auto offer = [&](int from, int to, int overlap) {
+        best[from].push({overlap, to});
+        if ((int)best[from].size() > neighbours) {
+            best[from].pop();
+        }
+    };
+
+    std::vector<int> active;
+    for (int j : order) {
+        const Window &window = candidates[j].Visible;
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [&](int i) {
+                                        return candidates[i].Visible.End +
+                                                   max_transition <=
+                                               window.Start;
+                                    }),
+                     active.end());
+
+        for (int i : active) {
+            int overlap =
+                std::min(candidates[i].Visible.End, window.End) - window.Start;
+            offer(i, j, overlap);
+            offer(j, i, overlap);
+        }
+
+        // Nearest by start: on a dense night most of the active candidates
+        // overlap, and pairing them all would grow quadratically
+        active.push_back(j);
+        if ((int)active.size() > neighbours) {
+            active.erase(active.begin());
+        }
+    }
+
+    std::set<std::pair<int, int>> pairs;
+    for (size_t i = 0; i < best.size(); i++) {
+        while (!best[i].empty()) {
+            int j = best[i].top().second;
+            best[i].pop();
+            pairs.insert({std::min((int)i, j), std::max((int)i, j)});
+        }
+    }
+
+    // The minimum transition holds between every pair already
+    int min_transition = MinTransitionTime(telescope);
+    for (auto pair : pairs) {
+        const Candidate &from = candidates[pair.first];
+        const Candidate &to = candidates[pair.second];
+        int time = TransitionTime(telescope, from, to);
+        if (time > min_transition) {
+            transitions.push_back(Transition{pair.first, pair.second, time});
+        }
+    }
+
+    return transitions;
+}
+
+#endif
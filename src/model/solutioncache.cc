@@ -0,0 +1,267 @@
+#ifndef SCHEDULER_SOLUTION_CACHE
+#define SCHEDULER_SOLUTION_CACHE
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ortools/sat/cp_model.pb.h"
+#include "ortools/sat/sat_parameters.pb.h"
+
+// Solver responses of previous runs, keyed by a fingerprint of the model and
+// the solver parameters.
+//
+// Names and hints do not change what is solved, so both are cleared before
+// hashing. Every entry keeps the variable names next to the response: when
+// no entry matches, the entries of the last run, one per component, still
+// hint the variables of the same name, which survive small changes of the
+// catalog. Names are given by the caller, as models built without names
+// still know them.
+//
+// A run reads the manifest of the last one when the cache is opened and
+// writes its own with Finish(), which also keeps the directory to the
+// `max_entries` most recently used entries.
+class SolutionCache {
+  public:
+    SolutionCache(const std::string &directory, int max_entries) {
+        this->Directory = directory;
+        this->MaxEntries = max_entries;
+        std::error_code error;
+        std::filesystem::create_directories(this->Directory, error);
+
+        std::ifstream manifest(this->Directory / "last_run");
+        std::string fingerprint;
+        while (std::getline(manifest, fingerprint)) {
+            this->Read(fingerprint, this->LastRun);
+        }
+    }
+
+    static std::string
+    Fingerprint(const operations_research::sat::CpModelProto &model,
+                const operations_research::sat::SatParameters &parameters) {
+        operations_research::sat::CpModelProto canonical = model;
+        canonical.clear_name();
+        canonical.clear_solution_hint();
+        for (int i = 0; i < canonical.variables_size(); i++) {
+            canonical.mutable_variables(i)->clear_name();
+        }
+        for (int i = 0; i < canonical.constraints_size(); i++) {
+            canonical.mutable_constraints(i)->clear_name();
+        }
+
+        std::string bytes = canonical.SerializeAsString();
+        bytes += parameters.SerializeAsString();
+
+        char fingerprint[33];
+        snprintf(fingerprint, sizeof(fingerprint), "%016llx%016llx",
+                 (unsigned long long)Hash(bytes, 0xcbf29ce484222325ULL),
+                 (unsigned long long)Hash(bytes, 0x84222325cbf29ce4ULL));
+
+        return fingerprint;
+    }
+
+    // Response of an identical instance, only when it was solved for good
+    bool Find(const std::string &fingerprint,
+              operations_research::sat::CpSolverResponse &response) const {
+        using namespace operations_research::sat;
+
+        std::filesystem::path path = this->Path(fingerprint, ".response");
+        if (!this->Load(path, response)) {
+            return false;
+        }
+
+        if (response.status() != CpSolverStatus::OPTIMAL &&
+            response.status() != CpSolverStatus::INFEASIBLE) {
+            return false;
+        }
+
+        // Entries are evicted by the time of their last use
+        std::error_code error;
+        std::filesystem::last_write_time(
+            path, std::filesystem::file_time_type::clock::now(), error);
+        return true;
+    }
+
+    // Entries are written aside and renamed into place, so components solved
+    // side by side never read a half written one
+    void Store(const std::string &fingerprint,
+               const std::vector<std::string> &names,
+               const operations_research::sat::CpSolverResponse &response)
+        const {
+        std::string lines;
+        for (const std::string &name : names) {
+            lines += name + "\n";
+        }
+
+        this->Write(this->Path(fingerprint, ".names"), lines);
+        this->Write(this->Path(fingerprint, ".response"),
+                    response.SerializeAsString());
+    }
+
+    // Hints `model` with the values of cached solutions, matched by
+    // variable name: the entry of the same fingerprint when it was not
+    // solved for good, every entry of the last run otherwise. Cached values
+    // take precedence over the hints already in the model, which are kept
+    // for the other variables. Returns the variables hinted from the cache.
+    int Hint(const std::string &fingerprint,
+             operations_research::sat::CpModelProto &model,
+             const std::vector<std::string> &names) const {
+        std::map<std::string, int64_t> same;
+        const std::map<std::string, int64_t> &values =
+            this->Read(fingerprint, same) ? same : this->LastRun;
+        if (values.empty()) {
+            return 0;
+        }
+
+        std::map<int, int64_t> hints;
+        const auto &existing = model.solution_hint();
+        for (int i = 0; i < existing.vars_size(); i++) {
+            hints[existing.vars(i)] = existing.values(i);
+        }
+
+        int hinted = 0;
+        for (int i = 0; i < model.variables_size() && i < (int)names.size();
+             i++) {
+            const auto &variable = model.variables(i);
+            auto value = values.find(names[i]);
+            if (names[i].empty() || value == values.end() ||
+                variable.domain_size() == 0 ||
+                value->second < variable.domain(0) ||
+                value->second > variable.domain(variable.domain_size() - 1)) {
+                continue;
+            }
+
+            hints[i] = value->second;
+            hinted++;
+        }
+
+        if (hinted == 0) {
+            return 0;
+        }
+
+        model.clear_solution_hint();
+        for (auto hint : hints) {
+            model.mutable_solution_hint()->add_vars(hint.first);
+            model.mutable_solution_hint()->add_values(hint.second);
+        }
+
+        return hinted;
+    }
+
+    // Records the entries of this run for the next one, then removes the
+    // least recently used entries of other runs beyond the limit
+    void Finish(const std::vector<std::string> &fingerprints) const {
+        std::string lines;
+        for (const std::string &fingerprint : fingerprints) {
+            lines += fingerprint + "\n";
+        }
+        this->Write(this->Directory / "last_run", lines);
+
+        std::set<std::string> kept(fingerprints.begin(), fingerprints.end());
+        std::vector<std::pair<std::filesystem::file_time_type, std::string>>
+            entries;
+        std::error_code error;
+        for (const auto &entry :
+             std::filesystem::directory_iterator(this->Directory, error)) {
+            std::string fingerprint = entry.path().stem().string();
+            if (entry.path().extension() == ".response" &&
+                !kept.count(fingerprint)) {
+                entries.push_back({entry.last_write_time(error), fingerprint});
+            }
+        }
+
+        std::sort(entries.rbegin(), entries.rend());
+        int room = std::max(0, this->MaxEntries - (int)kept.size());
+        for (size_t i = room; i < entries.size(); i++) {
+            std::filesystem::remove(this->Path(entries[i].second, ".response"),
+                                    error);
+            std::filesystem::remove(this->Path(entries[i].second, ".names"),
+                                    error);
+        }
+    }
+
+  private:
+    std::filesystem::path Directory;
+    int MaxEntries;
+
+    // Values of the last run's entries by variable name
+    std::map<std::string, int64_t> LastRun;
+
+    // FNV-1a
+    static uint64_t Hash(const std::string &bytes, uint64_t seed) {
+        uint64_t hash = seed;
+        for (unsigned char byte : bytes) {
+            hash ^= byte;
+            hash *= 0x100000001b3ULL;
+        }
+
+        return hash;
+    }
+
+    std::filesystem::path Path(const std::string &fingerprint,
+                               const std::string &extension) const {
+        return this->Directory / (fingerprint + extension);
+    }
+
+    void Write(const std::filesystem::path &path,
+               const std::string &bytes) const {
+        std::ostringstream suffix;
+        suffix << ".tmp" << std::this_thread::get_id();
+        std::filesystem::path temporary = path;
+        temporary += suffix.str();
+
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(bytes.data(), bytes.size());
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+    }
+
+    // Adds the values of an entry to `values` by name, false when it has
+    // none
+    bool Read(const std::string &fingerprint,
+              std::map<std::string, int64_t> &values) const {
+        operations_research::sat::CpSolverResponse response;
+        if (!this->Load(this->Path(fingerprint, ".response"), response) ||
+            response.solution_size() == 0) {
+            return false;
+        }
+
+        std::ifstream lines(this->Path(fingerprint, ".names"));
+        std::string name;
+        bool found = false;
+        for (int i = 0; std::getline(lines, name); i++) {
+            if (!name.empty() && i < response.solution_size()) {
+                values[name] = response.solution(i);
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
+    bool Load(const std::filesystem::path &path,
+              operations_research::sat::CpSolverResponse &response) const {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+
+        std::stringstream bytes;
+        bytes << file.rdbuf();
+
+        return response.ParseFromString(bytes.str());
+    }
+};
+
+#endif
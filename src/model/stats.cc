@@ -0,0 +1,227 @@
+#ifndef SCHEDULER_STATS
+#define SCHEDULER_STATS
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./allocations.cc"
+#include "./perfcounters.cc"
+#include "./trace.cc"
+
+// Wall time per pipeline phase and event counters of one run, reported as
+// JSON.
+//
+// Code is instrumented through the STATS_* macros below, which expand to
+// nothing unless SCHEDULER_WITH_STATS is defined; built in, they cost a
+// relaxed flag test until Stats::Enable() is called. Phases are named
+// "phase" or "phase/step" and listed in the order they first run; while
+// tracing, each one is a span of the trace too, and with hardware counters
+// or allocations enabled each one is a region of them.
+class Stats {
+  public:
+    enum Counter {
+        MOON_CALLS,
+        LST_CALLS,
+        TWILIGHT_CALLS,
+        VISIBILITY_EVALUATIONS,
+        OBJECTS,
+        CANDIDATES,
+        COMPONENTS,
+        VARIABLES,
+        CONSTRAINTS,
+        COUNTERS
+    };
+
+    static void Enable() { Enabled().store(true); }
+
+    static bool IsEnabled() {
+        return Enabled().load(std::memory_order_relaxed);
+    }
+
+    static void Count(Counter counter, int64_t amount = 1) {
+        if (IsEnabled()) {
+            Counters()[counter].fetch_add(amount, std::memory_order_relaxed);
+        }
+    }
+
+    // Adds the wall time until it is destroyed, or moves on to the next
+    // phase, to the phase it was started with
+    class Timer {
+      public:
+        Timer(const char *phase) { this->Start(phase); }
+
+        ~Timer() { this->Stop(); }
+
+        void Next(const char *phase) {
+            this->Stop();
+            this->Start(phase);
+        }
+
+        void Stop() {
+            if (this->Phase == nullptr) {
+                return;
+            }
+
+            auto end = std::chrono::steady_clock::now();
+            if (IsEnabled()) {
+                Record(this->Phase,
+                       std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           end - this->Begin)
+                           .count());
+            }
+
+            PerfCounters::Sample counters;
+            if (this->Counting && PerfCounters::Read(counters)) {
+                PerfCounters::Record(this->Phase, this->Counters, counters);
+            }
+
+            Allocations::Sample allocations;
+            if (this->Allocating && Allocations::Read(allocations)) {
+                Allocations::Record(this->Phase, this->Heap,
+                                    allocations);
+            }
+
+            Trace::Complete(this->Phase, this->Begin, end);
+            this->Phase = nullptr;
+        }
+
+      private:
+        const char *Phase = nullptr;
+        std::chrono::steady_clock::time_point Begin;
+        bool Counting = false;
+        PerfCounters::Sample Counters;
+        bool Allocating = false;
+        Allocations::Sample Heap;
+
+        void Start(const char *phase) {
+            if (IsEnabled() || Trace::IsEnabled()) {
+                this->Phase = phase;
+                this->Counting = PerfCounters::Read(this->Counters);
+                this->Allocating = Allocations::Read(this->Heap);
+                this->Begin = std::chrono::steady_clock::now();
+            }
+        }
+    };
+
+    // Extra member of the report, `json` being any JSON value
+    static void Section(const std::string &name, const std::string &json) {
+        std::lock_guard<std::mutex> lock(Mutex());
+        for (auto &section : Sections()) {
+            if (section.first == name) {
+                section.second = json;
+                return;
+            }
+        }
+
+        Sections().push_back({name, json});
+    }
+
+    static std::string Json() {
+        std::lock_guard<std::mutex> lock(Mutex());
+        std::ostringstream json;
+        json << "{\"phases\":{";
+        for (size_t i = 0; i < Phases().size(); i++) {
+            const Phase &phase = Phases()[i];
+            json << (i ? "," : "") << "\"" << phase.Name << "\":{\"calls\":"
+                 << phase.Calls << ",\"seconds\":" << phase.Nanoseconds * 1e-9
+                 << "}";
+        }
+
+        json << "},\"counters\":{";
+        for (int i = 0; i < COUNTERS; i++) {
+            json << (i ? "," : "") << "\"" << CounterName((Counter)i)
+                 << "\":" << Counters()[i].load();
+        }
+        json << "}";
+
+        if (PerfCounters::IsEnabled()) {
+            json << ",\"hardware\":" << PerfCounters::Json();
+        }
+
+        if (Allocations::IsEnabled()) {
+            json << ",\"memory\":" << Allocations::Json();
+        }
+
+        for (const auto &section : Sections()) {
+            json << ",\"" << section.first << "\":" << section.second;
+        }
+        json << "}";
+
+        return json.str();
+    }
+
+  private:
+    struct Phase {
+        std::string Name;
+        int64_t Calls;
+        int64_t Nanoseconds;
+    };
+
+    static const char *CounterName(Counter counter) {
+        static const char *names[COUNTERS] = {
+            "moon_calls",  "lst_calls",  "twilight_calls",
+            "visibility_evaluations",    "objects",
+            "candidates",  "components", "variables",
+            "constraints"};
+
+        return names[counter];
+    }
+
+    static void Record(const char *name, int64_t nanoseconds) {
+        std::lock_guard<std::mutex> lock(Mutex());
+        for (Phase &phase : Phases()) {
+            if (phase.Name == name) {
+                phase.Calls++;
+                phase.Nanoseconds += nanoseconds;
+                return;
+            }
+        }
+
+        Phases().push_back(Phase{name, 1, nanoseconds});
+    }
+
+    static std::atomic<bool> &Enabled() {
+        static std::atomic<bool> enabled(false);
+        return enabled;
+    }
+
+    static std::atomic<int64_t> *Counters() {
+        static std::atomic<int64_t> counters[COUNTERS] = {};
+        return counters;
+    }
+
+    static std::mutex &Mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::vector<Phase> &Phases() {
+        static std::vector<Phase> phases;
+        return phases;
+    }
+
+    static std::vector<std::pair<std::string, std::string>> &Sections() {
+        static std::vector<std::pair<std::string, std::string>> sections;
+        return sections;
+    }
+};
+
+#ifdef SCHEDULER_WITH_STATS
+#define STATS_TIMER(phase) Stats::Timer stats_timer(phase)
+#define STATS_NEXT(phase) stats_timer.Next(phase)
+#define STATS_STOP() stats_timer.Stop()
+#define STATS_COUNT(counter, amount) Stats::Count(Stats::counter, amount)
+#else
+#define STATS_TIMER(phase)
+#define STATS_NEXT(phase)
+#define STATS_STOP()
+#define STATS_COUNT(counter, amount)
+#endif
+
+#endif
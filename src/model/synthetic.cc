@@ -0,0 +1,204 @@
+#ifndef SCHEDULER_SYNTHETIC
+#define SCHEDULER_SYNTHETIC
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./object.cc"
+extern "C" {
+#include "../include/libastro.h"
+}
+
+// Seeded instances for scaling studies and regression runs.
+//
+// Only the raw output of std::mt19937_64 is used, which the standard fixes
+// for every implementation; the <random> distributions are not, so every
+// draw is made here and a seed gives the same catalog on any machine.
+class Synthetic {
+  public:
+    enum Sky { UNIFORM, GALACTIC, CLUSTERED };
+
+    // Clusters of the clustered sky, each of 0.2 to 2 degrees
+    static constexpr int CLUSTERS = 256;
+
+    // Scale height, in degrees of galactic latitude, of the galactic sky
+    static constexpr double DISK_HEIGHT = 8;
+
+    // Mean priority, most objects are routine and a few urgent
+    static constexpr double PRIORITY_MEAN = 15;
+
+    // Log-normal observation time, in minutes
+    static constexpr double OBSERVATION_MEDIAN = 20;
+    static constexpr double OBSERVATION_SIGMA = 0.6;
+    static constexpr int OBSERVATION_MAX = 120;
+
+    Synthetic(uint64_t seed, Sky sky) : Generator(seed) {
+        this->Model = sky;
+        for (int i = 0; sky == CLUSTERED && i < CLUSTERS; i++) {
+            Cluster cluster;
+            this->UniformPosition(cluster.Ra, cluster.Dec);
+            cluster.Radius = 0.2 + 1.8 * this->Uniform();
+            this->Clusters.push_back(cluster);
+        }
+    }
+
+    static bool ParseSky(const std::string &name, Sky &sky) {
+        const char *names[] = {"uniform", "galactic", "clustered"};
+        for (int i = 0; i < 3; i++) {
+            if (name == names[i]) {
+                sky = (Sky)i;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    Object Next(int id) {
+        double ra, dec;
+        switch (this->Model) {
+        case GALACTIC:
+            this->GalacticPosition(ra, dec);
+            break;
+        case CLUSTERED:
+            this->ClusteredPosition(ra, dec);
+            break;
+        default:
+            this->UniformPosition(ra, dec);
+        }
+
+        unsigned int priority =
+            std::min(99.0, floor(this->Exponential(PRIORITY_MEAN)));
+        unsigned int observation = std::clamp(
+            (int)llround(OBSERVATION_MEDIAN *
+                         exp(OBSERVATION_SIGMA * this->Normal())),
+            1, OBSERVATION_MAX);
+
+        return Object(id, ra, dec, priority, observation);
+    }
+
+    // Text catalog line: coordinates, galactic coordinates, no optional
+    // columns, then the priority and the observation time
+    static void WriteText(std::ostream &stream, const Object &object) {
+        double lat, lng;
+        eq_gal(J2000, hrrad(object.GetRa()), degrad(object.GetDec()), &lat,
+               &lng);
+
+        char line[128];
+        snprintf(line, sizeof(line), "%d %s %s %f %f galactic - - - - %u %u\n",
+                 object.GetId(), Sexagesimal(object.GetRa(), 24).c_str(),
+                 Sexagesimal(object.GetDec(), 0).c_str(), raddeg(lng),
+                 raddeg(lat), object.GetPriority(),
+                 object.GetObservationTime());
+        stream << line;
+    }
+
+    // Configuration of site `index` of a network of `count` telescopes, with
+    // latitudes spread evenly from 35 S to 50 N and longitudes from 100 W to
+    // 100 E. Further from Greenwich the night of a date starts before its
+    // dusk, which the candidate search does not handle.
+    static std::string TelescopeConfig(int index, int count) {
+        double fraction = count > 1 ? (double)index / (count - 1) : 0.5;
+        double latitude = -35 + 85 * fraction;
+        double longitude = -100 + 200 * (index + 0.5) / count;
+        double min_height = 30;
+
+        char config[512];
+        snprintf(config, sizeof(config),
+                 "[observatory]\n"
+                 "latitude = %.4f\n"
+                 "longitude = %.4f\n"
+                 "altitude = %d\n"
+                 "\n"
+                 "[limits]\n"
+                 "min_height = %.0f\n"
+                 "min_lunar_dist = 20\n"
+                 "min_dec_N = %.4f\n"
+                 "min_dec_S = %.4f\n"
+                 "mount_HA = 5\n",
+                 latitude, longitude, 2000 + 100 * (index % 6), min_height,
+                 std::min(90.0, 90 - latitude - min_height),
+                 std::min(90.0, 90 + latitude - min_height));
+
+        return config;
+    }
+
+  private:
+    struct Cluster {
+        double Ra;
+        double Dec;
+        double Radius;
+    };
+
+    std::mt19937_64 Generator;
+    Sky Model;
+    std::vector<Cluster> Clusters;
+
+    // [0, 1) with the 53 bits of a double
+    double Uniform() { return (this->Generator() >> 11) * 0x1.0p-53; }
+
+    // Box-Muller, one of the pair is enough
+    double Normal() {
+        double u = 1 - this->Uniform();
+        return sqrt(-2 * log(u)) * cos(2 * PI * this->Uniform());
+    }
+
+    double Exponential(double mean) { return -mean * log(1 - this->Uniform()); }
+
+    void UniformPosition(double &ra, double &dec) {
+        ra = 24 * this->Uniform();
+        dec = raddeg(asin(2 * this->Uniform() - 1));
+    }
+
+    // Exponential disk in galactic latitude, uniform in longitude
+    void GalacticPosition(double &ra, double &dec) {
+        double lat;
+        do {
+            lat = this->Exponential(DISK_HEIGHT);
+        } while (lat > 90);
+
+        if (this->Uniform() < 0.5) {
+            lat = -lat;
+        }
+
+        double lng = 360 * this->Uniform();
+        gal_eq(J2000, degrad(lat), degrad(lng), &ra, &dec);
+        range(&ra, 2 * PI);
+        ra = radhr(ra);
+        dec = raddeg(dec);
+    }
+
+    // Gaussian around the centre of a random cluster
+    void ClusteredPosition(double &ra, double &dec) {
+        const Cluster &cluster =
+            this->Clusters[(size_t)(this->Uniform() * CLUSTERS)];
+        dec = std::clamp(cluster.Dec + cluster.Radius * this->Normal(), -90.0,
+                         90.0);
+        ra = cluster.Ra + cluster.Radius * this->Normal() /
+                              (15 * std::max(0.01, cos(degrad(dec))));
+        range(&ra, 24.0);
+    }
+
+    // Rounded to the second, modulo `wrap` units when it is not 0
+    static std::string Sexagesimal(double value, int wrap) {
+        long long seconds = llround(fabs(value) * 3600);
+        if (wrap > 0) {
+            seconds %= wrap * 3600;
+        }
+
+        char text[32];
+        snprintf(text, sizeof(text), "%s%02lld:%02lld:%02lld",
+                 value < 0 ? "-" : "", seconds / 3600, seconds / 60 % 60,
+                 seconds % 60);
+
+        return text;
+    }
+};
+
+#endif
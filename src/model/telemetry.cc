@@ -0,0 +1,206 @@
+#ifndef SCHEDULER_TELEMETRY
+#define SCHEDULER_TELEMETRY
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include "ortools/sat/cp_model.pb.h"
+
+#include "./presolve.cc"
+
+// Size of the models and figures of their solves, added up over the
+// components of a night. Large components are solved one after another and
+// the small ones side by side, so the wall time of the search is measured
+// by the caller; the status is the worst one.
+class SolverTelemetry {
+  public:
+    void AddModel(const operations_research::sat::CpModelProto &model,
+                  int candidates) {
+        this->Components++;
+        this->Candidates += candidates;
+        this->Variables += model.variables_size();
+        this->Constraints += model.constraints_size();
+        this->Bytes += model.ByteSizeLong();
+    }
+
+    // CP-SAT's own presolve only reports in its log, so the reductions are
+    // the scheduler's
+    void SetPresolve(const PresolveStats &presolve) {
+        this->Presolve = presolve;
+    }
+
+    void AddResponse(
+        const operations_research::sat::CpSolverResponse &response,
+        bool cached) {
+        using namespace operations_research::sat;
+
+        if (this->Solves == 0 ||
+            Rank(response.status()) < Rank(this->Status)) {
+            this->Status = response.status();
+        }
+
+        this->Solves++;
+        this->Cached += cached;
+        this->Objective += response.objective_value();
+        this->BestBound += response.best_objective_bound();
+        this->LongestComponentTime =
+            std::max(this->LongestComponentTime, response.wall_time());
+        this->UserTime += response.user_time();
+        this->DeterministicTime += response.deterministic_time();
+        this->Conflicts += response.num_conflicts();
+        this->Branches += response.num_branches();
+        this->Propagations += response.num_binary_propagations() +
+                              response.num_integer_propagations();
+        this->Booleans += response.num_booleans();
+
+        // The worker that found the last solution leads the solution info
+        if (!cached && !response.solution_info().empty()) {
+            std::string info = response.solution_info();
+            this->Workers[info.substr(0, info.find(' '))]++;
+        }
+    }
+
+    int GetCandidates() const { return this->Candidates; }
+
+    // Seconds spent solving every component
+    void SetWallTime(double seconds) { this->WallTime = seconds; }
+
+    double GetObjective() const { return this->Objective; }
+
+    std::string GetStatusName() const {
+        return operations_research::sat::CpSolverStatus_Name(this->Status);
+    }
+
+    // Relative distance between the objective and its bound
+    double GetGap() const {
+        return fabs(this->Objective - this->BestBound) /
+               std::max(1.0, fabs(this->Objective));
+    }
+
+    std::string ModelJson() const {
+        std::ostringstream json;
+        json << "{\"components\":" << this->Components
+             << ",\"candidates\":" << this->Candidates
+             << ",\"variables\":" << this->Variables
+             << ",\"constraints\":" << this->Constraints
+             << ",\"proto_bytes\":" << this->Bytes
+             << ",\"presolve\":{\"candidates\":" << this->Presolve.Candidates
+             << ",\"removed\":" << this->Presolve.Removed
+             << ",\"clusters\":" << this->Presolve.Clusters
+             << ",\"saturated\":" << this->Presolve.Saturated << "}}";
+
+        return json.str();
+    }
+
+    std::string SolverJson() const {
+        std::ostringstream json;
+        json << "{\"status\":\"" << this->GetStatusName()
+             << "\",\"objective\":" << this->Objective
+             << ",\"best_bound\":" << this->BestBound
+             << ",\"gap\":" << this->GetGap()
+             << ",\"wall_time\":" << this->WallTime
+             << ",\"longest_component_time\":" << this->LongestComponentTime
+             << ",\"user_time\":" << this->UserTime
+             << ",\"deterministic_time\":" << this->DeterministicTime
+             << ",\"conflicts\":" << this->Conflicts
+             << ",\"branches\":" << this->Branches
+             << ",\"propagations\":" << this->Propagations
+             << ",\"booleans\":" << this->Booleans
+             << ",\"cached\":" << this->Cached << ",\"workers\":{";
+        bool first = true;
+        for (const auto &worker : this->Workers) {
+            json << (first ? "" : ",") << "\"" << Escape(worker.first)
+                 << "\":" << worker.second;
+            first = false;
+        }
+        json << "}}";
+
+        return json.str();
+    }
+
+    void Print(std::ostream &stream) const {
+        stream << "status: " << this->GetStatusName() << std::endl;
+        stream << "objective: " << this->Objective << std::endl;
+        stream << "best_bound: " << this->BestBound << std::endl;
+        stream << "gap: " << this->GetGap() << std::endl;
+        stream << "components: " << this->Components << std::endl;
+        stream << "variables: " << this->Variables << std::endl;
+        stream << "constraints: " << this->Constraints << std::endl;
+        stream << "presolve_removed: " << this->Presolve.Removed << std::endl;
+        stream << "booleans: " << this->Booleans << std::endl;
+        stream << "conflicts: " << this->Conflicts << std::endl;
+        stream << "branches: " << this->Branches << std::endl;
+        stream << "propagations: " << this->Propagations << std::endl;
+        stream << "walltime: " << this->WallTime << std::endl;
+        stream << "longest_component_time: " << this->LongestComponentTime
+               << std::endl;
+        stream << "usertime: " << this->UserTime << std::endl;
+        stream << "deterministic_time: " << this->DeterministicTime
+               << std::endl;
+        for (const auto &worker : this->Workers) {
+            stream << "solutions by " << worker.first << ": "
+                   << worker.second << std::endl;
+        }
+    }
+
+  private:
+    int Components = 0;
+    int64_t Candidates = 0;
+    int64_t Variables = 0;
+    int64_t Constraints = 0;
+    int64_t Bytes = 0;
+    PresolveStats Presolve{};
+
+    int Solves = 0;
+    int Cached = 0;
+    operations_research::sat::CpSolverStatus Status =
+        operations_research::sat::CpSolverStatus::UNKNOWN;
+    double Objective = 0;
+    double BestBound = 0;
+    double WallTime = 0;
+    double LongestComponentTime = 0;
+    double UserTime = 0;
+    double DeterministicTime = 0;
+    int64_t Conflicts = 0;
+    int64_t Branches = 0;
+    int64_t Propagations = 0;
+    int64_t Booleans = 0;
+    std::map<std::string, int> Workers;
+
+    // Worst first: a night is only as solved as its least solved component
+    static int Rank(operations_research::sat::CpSolverStatus status) {
+        using namespace operations_research::sat;
+
+        switch (status) {
+        case CpSolverStatus::OPTIMAL:
+            return 4;
+        case CpSolverStatus::FEASIBLE:
+            return 3;
+        case CpSolverStatus::INFEASIBLE:
+            return 2;
+        case CpSolverStatus::UNKNOWN:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+
+    static std::string Escape(const std::string &text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+
+        return escaped;
+    }
+};
+
+#endif
@@ -2,9 +2,14 @@
 #define SCHEDULER_TELESCOPE
 
 #include "./TelescopeLimits.cc"
+#include "./TelescopeMount.cc"
 #include "./angle.cc"
+#include "./nightgrid.cc"
+#include "./stats.cc"
 #include "object.cc"
+#include <algorithm>
 #include <climits>
+#include <cmath>
 #include <iostream>
 #include <ostream>
 #include <string>
@@ -22,6 +27,14 @@ class Telescope {
         this->Longitude = lon;
         this->Altitude = altitude;
         this->Limits = limits;
+        this->Mount = TelescopeMount{};
+        this->MinAltitude = AltitudeLimit(limits);
+    }
+
+    Telescope(int id, double lat, double lon, int altitude, std::string name,
+              TelescopeLimits limits, TelescopeMount mount)
+        : Telescope(id, lat, lon, altitude, name, limits) {
+        this->Mount = mount;
     }
 
     Telescope(int id, double lat, double lon) {
@@ -30,6 +43,8 @@ class Telescope {
         this->Latitude = lat;
         this->Longitude = lon;
         this->Limits = TelescopeLimits{};
+        this->Mount = TelescopeMount{};
+        this->MinAltitude = AltitudeLimit(this->Limits);
     }
 
     int GetId() const { return this->Id; }
@@ -42,10 +57,99 @@ class Telescope {
 
     int GetAltitude() const { return this->Altitude; }
 
+    TelescopeLimits GetLimits() const { return this->Limits; }
+
+    TelescopeMount GetMount() const { return this->Mount; }
+
+    // Minutes to slew between two positions (RA in hours, Dec in degrees),
+    // both axes moving at once, including the settle time
+    int GetSlewTime(double from_ra, double from_dec, double to_ra,
+                    double to_dec) const {
+        if (this->Mount.RaSpeed <= 0 || this->Mount.DecSpeed <= 0) {
+            return 0;
+        }
+
+        double ra = fabs(hrdeg(from_ra - to_ra));
+        ra = std::min(ra, 360 - ra);
+        double dec = fabs(from_dec - to_dec);
+        double seconds = std::max(ra / this->Mount.RaSpeed,
+                                  dec / this->Mount.DecSpeed) +
+                         this->Mount.SettleTime;
+
+        return ceil(seconds / 60);
+    }
+
+    // Minutes to change between two instrument configurations, 0 stands for
+    // objects that take any configuration
+    int GetSetupTime(int from_configuration, int to_configuration) const {
+        if (from_configuration == to_configuration || from_configuration == 0 ||
+            to_configuration == 0) {
+            return 0;
+        }
+
+        return ceil(this->Mount.SetupTime / 60);
+    }
+
+    // Lowest altitude, in degrees, allowed by both MinHeight and MaxAirmass
+    double GetMinAltitude() const { return this->MinAltitude; }
+
+    // Local apparent sidereal time in hours
+    double GetLst(double julian_date) const {
+        double lst;
+        Now now;
+        now.n_mjd = julian_date;
+        now.n_lat = degrad(this->GetLatitude());
+        now.n_lng = degrad(this->GetLongitude());
+        now.n_temp = 15;
+        now.n_dip = now.n_elev = now.n_tz = 0;
+        now.n_pressure = 1010;
+        now.n_epoch = J2000;
+
+        STATS_COUNT(LST_CALLS, 1);
+        now_lst(&now, &lst);
+
+        return lst;
+    }
+
+    // Largest hour angle, in hours, at which an object at `dec` degrees stays
+    // above GetMinAltitude(). Solves sin(alt) = sin(lat) sin(dec) +
+    // cos(lat) cos(dec) cos(HA) once per object instead of converting every
+    // slot to horizontal coordinates. Returns 12 for objects that never go
+    // below the limit and -1 for objects that never reach it.
+    double GetMaxHourAngle(double dec) const {
+        double lat = degrad(this->GetLatitude());
+        double denominator = cos(lat) * cos(degrad(dec));
+        double numerator =
+            sin(degrad(this->MinAltitude)) - sin(lat) * sin(degrad(dec));
+        if (fabs(denominator) < 1e-12) {
+            return numerator <= 0 ? 12 : -1;
+        }
+
+        double cos_ha = numerator / denominator;
+        if (cos_ha <= -1) {
+            return 12;
+        }
+
+        if (cos_ha >= 1) {
+            return -1;
+        }
+
+        return radhr(acos(cos_ha));
+    }
+
+    // Hour angle in hours, within [-12, 12)
+    static double HourAngle(double lst, double ra) {
+        double ha = lst - ra;
+        range(&ha, 24.0);
+
+        return ha >= 12 ? ha - 24 : ha;
+    }
+
     int GetObservationTime(Now now) const {
         double julian_twilight_dawn;
         double julian_twilight_dusk;
         int status;
+        STATS_COUNT(TWILIGHT_CALLS, 1);
         twilight_cir(
             &now,
             -17.5 * PI / 180,
@@ -65,43 +169,57 @@ class Telescope {
                   << std::endl;
     }
 
+    // Reference check of a single instant, the scheduler evaluates the same
+    // limits from a NightGrid
     bool IsObjectVisible(double julian_date, Object object) const {
-        double moon_lat, moon_lon, moon_rho, moon_msp, moon_mdp;
-
-        // Moon separation
-        moon(julian_date, &moon_lat, &moon_lon, &moon_rho, &moon_msp,
-             &moon_mdp);
+        double moon_ra, moon_dec;
+        NightGrid::Moon(julian_date, &moon_ra, &moon_dec);
+        if (this->IsNearMoon(moon_ra, moon_dec, object.GetPosition())) {
+            return false;
+        }
 
-        auto separation = Angle::separation(moon_lat, moon_lon, object.GetDec(),
-                                            object.GetRa())
-                              .GetFactor();
-        if (separation <= this->Limits.MinLunarDistance &&
-            separation > -this->Limits.MinLunarDistance) {
+        double lst = this->GetLst(julian_date);
+        if (!this->IsWithinLimits(lst, object.GetPosition())) {
             return false;
         }
 
-        double diff_lat = this->GetLatitude() - object.GetDec();
-        double diff_lon = this->GetLongitude() - object.GetRa();
+        double alt, az;
+        hadec_aa(degrad(this->GetLatitude()),
+                 hrrad(HourAngle(lst, object.GetRa())),
+                 degrad(object.GetDec()), &alt, &az);
 
-        double lst;
-        Now now;
-        now.n_mjd = julian_date;
-        now.n_lat = this->GetLatitude();
-        now.n_lng = this->GetLongitude();
-        now.n_temp = 15;
-        now.n_dip = now.n_elev = now.n_tz = 0;
-        now.n_pressure = 1010;
-        now.n_epoch = J2000;
+        return raddeg(alt) >= this->MinAltitude;
+    }
 
-        now_lst(&now, &lst);
-        auto lst_ra = lst - object.GetRa();
+    // Lunar distance check against a Moon position taken from a NightGrid
+    bool IsNearMoon(double moon_ra, double moon_dec,
+                    SkyPosition object) const {
+        return IsNear(moon_ra, moon_dec, this->Limits.MinLunarDistance,
+                      object);
+    }
+
+    // Whether the object is within `distance` degrees of the position
+    static bool IsNear(double ra, double dec, double distance,
+                       SkyPosition object) {
+        auto separation = raddeg(
+            Angle::separation(degrad(dec), hrrad(ra), degrad(object.Dec),
+                              hrrad(object.Ra))
+                .GetRadians());
+
+        return separation <= distance;
+    }
+
+    // Mount hour angle and declination limits at the given sidereal time
+    bool IsWithinLimits(double lst, SkyPosition object) const {
+        auto lst_ra = lst - object.Ra;
+        range(&lst_ra, 24.0);
         if (lst_ra >= this->Limits.MountHA &&
             24.0 - lst_ra >= this->Limits.MountHA) {
             return false;
         }
 
-        if (object.GetDec() >= this->Limits.MinDecSouth ||
-            object.GetDec() <= -this->Limits.MinDecNord) {
+        if (object.Dec >= this->Limits.MinDecSouth ||
+            object.Dec <= -this->Limits.MinDecNord) {
             return false;
         }
 
@@ -115,6 +233,30 @@ class Telescope {
     double Longitude;
     int Altitude;
     TelescopeLimits Limits;
+    TelescopeMount Mount;
+    double MinAltitude;
+
+    // Altitude at which the airmass reaches MaxAirmass, found by bisection
+    // since libastro only converts altitude to airmass
+    static double AltitudeLimit(TelescopeLimits limits) {
+        if (limits.MaxAirmass <= 1) {
+            return limits.MinHeight;
+        }
+
+        double low = 0, high = 90;
+        for (int i = 0; i < 50; i++) {
+            double middle = (low + high) / 2;
+            double airmass_at_middle;
+            airmass(degrad(middle), &airmass_at_middle);
+            if (airmass_at_middle > limits.MaxAirmass) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+
+        return std::max(limits.MinHeight, high);
+    }
 };
 
 #endif
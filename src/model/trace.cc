@@ -0,0 +1,206 @@
+#ifndef SCHEDULER_TRACE
+#define SCHEDULER_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Timeline of a run in Chrome trace-event JSON, for chrome://tracing or
+// Perfetto.
+//
+// Every thread records into a ring buffer of its own, so recording takes no
+// lock: the thread is the only writer and publishes each event by bumping
+// its head. A thread takes the lock once, to register its buffer. When a
+// buffer wraps around the oldest events are dropped and counted. Buffers
+// outlive their threads and are written out at exit.
+class Trace {
+  public:
+    // Events kept per thread
+    static const size_t CAPACITY = 1 << 16;
+
+    // Called from the main thread
+    static void Enable() {
+        Origin();
+        MainThread() = std::this_thread::get_id();
+        Enabled().store(true);
+    }
+
+    static bool IsEnabled() {
+        return Enabled().load(std::memory_order_relaxed);
+    }
+
+    static std::chrono::steady_clock::time_point Now() {
+        return std::chrono::steady_clock::now();
+    }
+
+    // Span from `begin` to `end`, with an optional numeric argument
+    static void Complete(const char *name,
+                         std::chrono::steady_clock::time_point begin,
+                         std::chrono::steady_clock::time_point end,
+                         const char *argument = nullptr, double value = 0) {
+        if (IsEnabled()) {
+            Local().Push(Event{name, 'X', Micros(begin),
+                               Micros(end) - Micros(begin), argument, value});
+        }
+    }
+
+    static void Instant(const char *name, const char *argument = nullptr,
+                        double value = 0) {
+        if (IsEnabled()) {
+            Local().Push(
+                Event{name, 'i', Micros(Now()), 0, argument, value});
+        }
+    }
+
+    // Span from construction to destruction
+    class Span {
+      public:
+        Span(const char *name, const char *argument = nullptr,
+             double value = 0) {
+            if (IsEnabled()) {
+                this->Name = name;
+                this->Argument = argument;
+                this->Value = value;
+                this->Begin = Trace::Now();
+            }
+        }
+
+        ~Span() {
+            if (this->Name != nullptr) {
+                Complete(this->Name, this->Begin, Trace::Now(),
+                         this->Argument, this->Value);
+            }
+        }
+
+      private:
+        const char *Name = nullptr;
+        const char *Argument;
+        double Value;
+        std::chrono::steady_clock::time_point Begin;
+    };
+
+    // Writes every buffer; the threads that recorded must have finished
+    static bool Write(const std::string &path) {
+        std::lock_guard<std::mutex> lock(Mutex());
+        std::ofstream file(path, std::ios::trunc);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        bool first = true;
+        uint64_t dropped = 0;
+        for (const auto &buffer : Buffers()) {
+            file << (first ? "" : ",")
+                 << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                    "\"tid\":"
+                 << buffer->Thread << ",\"args\":{\"name\":\""
+                 << (buffer->Main ? "main" : "worker") << " "
+                 << buffer->Thread << "\"}}";
+            first = false;
+
+            uint64_t head = buffer->Head.load(std::memory_order_acquire);
+            uint64_t start = head > CAPACITY ? head - CAPACITY : 0;
+            dropped += start;
+            for (uint64_t i = start; i < head; i++) {
+                const Event &event = buffer->Events[i % CAPACITY];
+                file << ",{\"name\":\"" << event.Name << "\",\"ph\":\""
+                     << event.Phase << "\",\"pid\":1,\"tid\":"
+                     << buffer->Thread << ",\"ts\":" << event.Timestamp;
+                if (event.Phase == 'X') {
+                    file << ",\"dur\":" << event.Duration;
+                } else {
+                    file << ",\"s\":\"t\"";
+                }
+                if (event.Argument != nullptr) {
+                    file << ",\"args\":{\"" << event.Argument
+                         << "\":" << event.Value << "}";
+                }
+                file << "}";
+            }
+        }
+
+        file << "],\"otherData\":{\"dropped_events\":" << dropped << "}}"
+             << std::endl;
+
+        return (bool)file;
+    }
+
+  private:
+    struct Event {
+        const char *Name;
+        char Phase;
+        int64_t Timestamp;
+        int64_t Duration;
+        const char *Argument;
+        double Value;
+    };
+
+    struct Buffer {
+        int Thread;
+        bool Main;
+        std::atomic<uint64_t> Head{0};
+        std::unique_ptr<Event[]> Events{new Event[CAPACITY]};
+
+        void Push(const Event &event) {
+            uint64_t head = this->Head.load(std::memory_order_relaxed);
+            this->Events[head % CAPACITY] = event;
+            this->Head.store(head + 1, std::memory_order_release);
+        }
+    };
+
+    static int64_t Micros(std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   time - Origin())
+            .count();
+    }
+
+    static std::chrono::steady_clock::time_point Origin() {
+        static const auto origin = Now();
+        return origin;
+    }
+
+    static Buffer &Local() {
+        thread_local Buffer *buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(Mutex());
+            Buffers().push_back(std::make_unique<Buffer>());
+            buffer = Buffers().back().get();
+            buffer->Thread = Buffers().size() - 1;
+            buffer->Main = std::this_thread::get_id() == MainThread();
+        }
+
+        return *buffer;
+    }
+
+    static std::atomic<bool> &Enabled() {
+        static std::atomic<bool> enabled(false);
+        return enabled;
+    }
+
+    static std::thread::id &MainThread() {
+        static std::thread::id main;
+        return main;
+    }
+
+    static std::mutex &Mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::vector<std::unique_ptr<Buffer>> &Buffers() {
+        static std::vector<std::unique_ptr<Buffer>> buffers;
+        return buffers;
+    }
+};
+
+#ifdef SCHEDULER_WITH_STATS
+#define TRACE_SPAN(...) Trace::Span trace_span(__VA_ARGS__)
+#else
+#define TRACE_SPAN(...)
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef SCHEDULER_VARIABLE_NAMES
+#define SCHEDULER_VARIABLE_NAMES
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "ortools/sat/cp_model.h"
+
+// Where every variable of a model comes from: its telescope, object and,
+// for pieces and visits, which one.
+//
+// Names in the proto cost a string per variable to build and to copy into
+// every solver worker. Without them the model keeps this table instead,
+// sixteen bytes per variable, which gives back the same names on demand.
+class VariableNames {
+  public:
+    enum Kind : int16_t {
+        MAKESPAN,
+        TWILIGHT_START,
+        OBJECT_END,
+        SCHEDULE,
+        AIRMASS,
+        CHUNK_START,
+        CHUNK_SIZE,
+        CHUNK_END,
+        CHUNK,
+        VISIT_START,
+        OBJECT_INTERVAL,
+        CHUNK_INTERVAL,
+        VISIT_INTERVAL
+    };
+
+    struct Origin {
+        int32_t Variable;
+        int32_t Telescope;
+        int32_t Object;
+        Kind Type;
+        int16_t Piece;
+    };
+
+    VariableNames(bool named = true) { this->Named = named; }
+
+    // Whether names are written to the proto as well
+    bool IsNamed() const { return this->Named; }
+
+    operations_research::sat::IntVar
+    Name(operations_research::sat::IntVar variable, Kind kind, int telescope,
+         int object = -1, int piece = -1) {
+        this->Origins.push_back(Origin{variable.index(), telescope, object,
+                                       kind, (int16_t)piece});
+        return this->Named
+                   ? variable.WithName(Format(kind, telescope, object, piece))
+                   : variable;
+    }
+
+    operations_research::sat::BoolVar
+    Name(operations_research::sat::BoolVar variable, Kind kind, int telescope,
+         int object = -1, int piece = -1) {
+        this->Origins.push_back(Origin{variable.index(), telescope, object,
+                                       kind, (int16_t)piece});
+        return this->Named
+                   ? variable.WithName(Format(kind, telescope, object, piece))
+                   : variable;
+    }
+
+    // Intervals are constraints of the proto, so they are only named
+    operations_research::sat::IntervalVar
+    Name(operations_research::sat::IntervalVar interval, Kind kind,
+         int telescope, int object = -1, int piece = -1) const {
+        return this->Named
+                   ? interval.WithName(Format(kind, telescope, object, piece))
+                   : interval;
+    }
+
+    // Names of the first `variables` variables, by index
+    std::vector<std::string> GetAll(int variables) const {
+        std::vector<std::string> names(variables);
+        for (const Origin &origin : this->Origins) {
+            if (origin.Variable < variables) {
+                names[origin.Variable] = Format(origin.Type, origin.Telescope,
+                                                origin.Object, origin.Piece);
+            }
+        }
+
+        return names;
+    }
+
+    // Variables are created, and so recorded, in index order
+    const std::vector<Origin> &GetOrigins() const { return this->Origins; }
+
+  private:
+    bool Named;
+    std::vector<Origin> Origins;
+
+    static std::string Format(Kind kind, int telescope, int object,
+                              int piece) {
+        static const char *prefixes[] = {
+            "makespan",        "twilight_start", "object_end",
+            "schedule",        "airmass",        "chunk_start",
+            "chunk_size",      "chunk_end",      "chunk",
+            "visit_start",     "object_interval", "chunk_interval",
+            "visit_interval"};
+
+        if (kind == MAKESPAN) {
+            return absl::StrFormat("makespan_%d", telescope);
+        }
+
+        std::string name =
+            absl::StrFormat("%s_%d_%d", prefixes[kind], object, telescope);
+        if (piece >= 0) {
+            name += absl::StrFormat("_%d", piece);
+        }
+
+        return name;
+    }
+};
+
+#endif
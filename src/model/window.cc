@@ -0,0 +1,93 @@
+#ifndef SCHEDULER_WINDOW
+#define SCHEDULER_WINDOW
+
+#include <cstdint>
+#include <vector>
+
+// Visibility window in minutes since dusk, [Start, End)
+struct Window {
+    int Start;
+    int End;
+
+    int Length() const { return this->End - this->Start; }
+};
+
+// One bit per minute slot since dusk, set while the object is observable
+class Visibility {
+  public:
+    Visibility(int slots) {
+        this->Slots = slots;
+        this->Words = std::vector<uint64_t>((slots + 63) / 64, 0);
+    }
+
+    // Evaluates `visible(slot)` at every slot of the night. Fixed and
+    // moving objects only differ in the predicate they pass.
+    template <typename Visible>
+    static Visibility Scan(int slots, Visible visible) {
+        Visibility visibility(slots);
+        for (int slot = 0; slot < slots; slot++) {
+            if (visible(slot)) {
+                visibility.Set(slot);
+            }
+        }
+
+        return visibility;
+    }
+
+    int GetSlots() const { return this->Slots; }
+
+    bool Test(int slot) const {
+        return (this->Words[slot / 64] >> (slot % 64)) & 1;
+    }
+
+    void Set(int slot) { this->Words[slot / 64] |= (uint64_t)1 << (slot % 64); }
+
+    void Clear(int slot) {
+        this->Words[slot / 64] &= ~((uint64_t)1 << (slot % 64));
+    }
+
+  private:
+    int Slots;
+    std::vector<uint64_t> Words;
+};
+
+// Every run of consecutive visible slots at least `min_length` long
+inline std::vector<Window> FindWindows(const Visibility &visibility,
+                                       int min_length) {
+    std::vector<Window> windows;
+    int slots = visibility.GetSlots();
+    int slot = 0;
+    while (slot < slots) {
+        while (slot < slots && !visibility.Test(slot)) {
+            slot++;
+        }
+
+        int start = slot;
+        while (slot < slots && visibility.Test(slot)) {
+            slot++;
+        }
+
+        if (slot > start && slot - start >= min_length) {
+            windows.push_back(Window{start, slot});
+        }
+    }
+
+    return windows;
+}
+
+// Longest run at least `min_length` long, the earliest of equal ones. Its
+// start is the number of slots when there is none.
+inline Window FindLongestWindow(const Visibility &visibility,
+                                int min_length) {
+    Window longest{visibility.GetSlots(), visibility.GetSlots()};
+    for (Window window : FindWindows(visibility, min_length)) {
+        if (longest.Start == visibility.GetSlots() ||
+            window.Length() > longest.Length()) {
+            longest = window;
+        }
+    }
+
+    return longest;
+}
+
+#endif
@@ -0,0 +1,1241 @@
+#ifndef SCHEDULER_SCHEDULE
+#define SCHEDULER_SCHEDULE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+extern "C" {
+#include "include/libastro.h"
+}
+
+#include "ortools/sat/cp_model.h"
+#include "ortools/sat/cp_model.pb.h"
+#include "ortools/sat/cp_model_solver.h"
+
+#include "./model/airmass.cc"
+#include "./model/batching.cc"
+#include "./model/candidate.cc"
+#include "./model/components.cc"
+#include "./model/ephemeris.cc"
+#include "./model/nightgrid.cc"
+#include "./model/object.cc"
+#include "./model/presolve.cc"
+#include "./model/satellites.cc"
+#include "./model/skyindex.cc"
+#include "./model/slew.cc"
+#include "./model/solutioncache.cc"
+#include "./model/stats.cc"
+#include "./model/telemetry.cc"
+#include "./model/telescope.cc"
+#include "./model/variablenames.cc"
+#include "./model/window.cc"
+
+// Chebyshev nodes per night used to track moving objects
+const int EPHEMERIS_KNOTS = 5;
+
+// Satellite positions propagated per minute slot
+const int SATELLITE_SAMPLES = 2;
+
+// Linear segments and tolerance, in AirmassCurve::SCALE units, of the
+// airmass cost of each candidate
+const int AIRMASS_SEGMENTS = 4;
+const int64_t AIRMASS_TOLERANCE = 2;
+
+// Candidates with the largest window overlap kept per candidate in the
+// slew-time matrix
+const int SLEW_NEIGHBOURS = 8;
+
+// Most pieces a splittable object is observed in
+const int SPLIT_CHUNKS = 4;
+
+// Candidates starting right before each candidate searched for dominators
+const int PRESOLVE_NEIGHBOURS = 64;
+
+// Entries kept in the solution cache, the least recently used are removed
+const int CACHE_ENTRIES = 1024;
+
+// Candidates from which a component is solved with every worker instead of
+// next to the others on a worker of its own
+const int LARGE_COMPONENT = 64;
+
+// Cost of the candidate starting at `start`, bounded from below by the
+// segment of its airmass curve that contains the start. No segment is
+// selected, and the cost drops to zero, when the candidate is not scheduled.
+operations_research::sat::IntVar
+AddAirmassCost(operations_research::sat::CpModelBuilder &model,
+               operations_research::sat::IntVar start,
+               operations_research::sat::BoolVar presence,
+               const AirmassCurve &curve, VariableNames &names,
+               int telescope_id, int object_id) {
+    using namespace operations_research::sat;
+
+    IntVar cost = names.Name(model.NewIntVar({0, curve.GetMaxCost()}),
+                             VariableNames::AIRMASS, telescope_id, object_id);
+    std::vector<BoolVar> pieces;
+    for (auto segment : curve.GetSegments()) {
+        BoolVar piece = model.NewBoolVar();
+        model.AddGreaterOrEqual(start, segment.Start).OnlyEnforceIf(piece);
+        model.AddLessOrEqual(start, segment.End).OnlyEnforceIf(piece);
+
+        int64_t length = segment.End - segment.Start;
+        if (length == 0) {
+            model.AddGreaterOrEqual(cost, segment.CostStart)
+                .OnlyEnforceIf(piece);
+        } else {
+            // cost >= CostStart + (CostEnd - CostStart) (start - Start) / length
+            model
+                .AddGreaterOrEqual(
+                    LinearExpr::Term(cost, length) -
+                        LinearExpr::Term(start,
+                                         segment.CostEnd - segment.CostStart),
+                    segment.CostStart * segment.End -
+                        segment.CostEnd * segment.Start)
+                .OnlyEnforceIf(piece);
+        }
+
+        pieces.push_back(piece);
+    }
+
+    model.AddEquality(LinearExpr::Sum(pieces), presence);
+
+    return cost;
+}
+
+// Pieces of a split candidate: optional intervals of variable size, at least
+// the object's minimum chunk long and adding up to its observation time when
+// `presence` is set. Fixed intervals over the gaps between its windows keep
+// every piece inside one window, so the model grows linearly with the pieces.
+std::vector<operations_research::sat::IntervalVar>
+AddChunks(operations_research::sat::CpModelBuilder &model,
+          const Candidate &candidate, const Object &object,
+          operations_research::sat::BoolVar presence, int max_chunks,
+          VariableNames &names, int telescope_id) {
+    using namespace operations_research::sat;
+
+    int id = object.GetId();
+    int observation_time = object.GetObservationTime();
+    int min_chunk = object.GetMinChunk();
+    int count = std::min(max_chunks, observation_time / min_chunk);
+    Window span = candidate.Visible;
+
+    std::vector<IntervalVar> chunks;
+    std::vector<IntVar> sizes;
+    for (int c = 0; c < count; c++) {
+        IntVar start =
+            names.Name(model.NewIntVar({span.Start, span.End}),
+                       VariableNames::CHUNK_START, telescope_id, id, c);
+        IntVar size =
+            names.Name(model.NewIntVar({0, observation_time}),
+                       VariableNames::CHUNK_SIZE, telescope_id, id, c);
+        IntVar end =
+            names.Name(model.NewIntVar({span.Start, span.End}),
+                       VariableNames::CHUNK_END, telescope_id, id, c);
+        BoolVar chunk_presence = names.Name(
+            model.NewBoolVar(), VariableNames::CHUNK, telescope_id, id, c);
+        IntervalVar chunk = names.Name(
+            model.NewOptionalIntervalVar(start, size, end, chunk_presence),
+            VariableNames::CHUNK_INTERVAL, telescope_id, id, c);
+
+        model.AddGreaterOrEqual(size, min_chunk)
+            .OnlyEnforceIf(chunk_presence);
+        model.AddEquality(size, 0).OnlyEnforceIf(chunk_presence.Not());
+        model.AddImplication(chunk_presence, presence);
+
+        // Pieces are used and placed in order
+        if (c > 0) {
+            model.AddImplication(chunk_presence,
+                                 chunks.back().PresenceBoolVar());
+            model.AddLessOrEqual(chunks.back().EndExpr(), start)
+                .OnlyEnforceIf(chunk_presence);
+        }
+
+        chunks.push_back(chunk);
+        sizes.push_back(size);
+    }
+
+    model.AddEquality(LinearExpr::Sum(sizes),
+                      LinearExpr::Term(presence, observation_time));
+
+    std::vector<IntervalVar> blocked = chunks;
+    for (size_t w = 1; w < candidate.Windows.size(); w++) {
+        int gap_start = candidate.Windows[w - 1].End;
+        int gap_end = candidate.Windows[w].Start;
+        blocked.push_back(
+            model.NewFixedSizeIntervalVar(gap_start, gap_end - gap_start));
+    }
+    model.AddNoOverlap(blocked);
+
+    return chunks;
+}
+
+// Visits of a monitored candidate: a chain of intervals sharing `presence`,
+// each starting between the minimum and maximum separation after the
+// previous one. As with pieces, fixed intervals over the gaps between its
+// windows keep every visit inside one window.
+std::vector<operations_research::sat::IntervalVar>
+AddVisits(operations_research::sat::CpModelBuilder &model,
+          const Candidate &candidate, const Object &object,
+          operations_research::sat::BoolVar presence, VariableNames &names,
+          int telescope_id) {
+    using namespace operations_research::sat;
+
+    int id = object.GetId();
+    Cadence cadence = object.GetCadence();
+    int observation_time = object.GetObservationTime();
+    Window span = candidate.Visible;
+
+    std::vector<IntervalVar> visits;
+    std::vector<IntVar> starts;
+    for (unsigned int v = 0; v < cadence.Visits; v++) {
+        // Earlier and later visits bound the start of each one
+        int earliest = span.Start + v * cadence.MinSeparation;
+        int latest = span.End - observation_time -
+                     (cadence.Visits - 1 - v) * cadence.MinSeparation;
+        IntVar start =
+            names.Name(model.NewIntVar({earliest, latest}),
+                       VariableNames::VISIT_START, telescope_id, id, v);
+        IntervalVar visit = names.Name(
+            model.NewOptionalFixedSizeIntervalVar(start, observation_time,
+                                                  presence),
+            VariableNames::VISIT_INTERVAL, telescope_id, id, v);
+
+        if (v > 0) {
+            model.AddLinearConstraint(
+                     LinearExpr(start) - starts.back(),
+                     {cadence.MinSeparation, cadence.MaxSeparation})
+                .OnlyEnforceIf(presence);
+        }
+
+        visits.push_back(visit);
+        starts.push_back(start);
+    }
+
+    std::vector<IntervalVar> blocked = visits;
+    for (size_t w = 1; w < candidate.Windows.size(); w++) {
+        int gap_start = candidate.Windows[w - 1].End;
+        int gap_end = candidate.Windows[w].Start;
+        blocked.push_back(
+            model.NewFixedSizeIntervalVar(gap_start, gap_end - gap_start));
+    }
+    model.AddNoOverlap(blocked);
+
+    return visits;
+}
+
+// Visibility windows of the objects that one telescope can observe during
+// the night of `julian_date`, in minutes from its dusk. `horizon` receives
+// the length of the night and `dusk` its start.
+std::vector<Candidate> FindCandidates(double julian_date,
+                                      const Telescope &telescope,
+                                      int telescope_index,
+                                      const std::vector<Object> &objects,
+                                      const SkyIndex &index,
+                                      const std::vector<Obj> &satellites,
+                                      int &horizon, double &dusk) {
+    Now now;
+    now.n_mjd = julian_date;
+    now.n_lat = telescope.GetLatitude() * PI / 180;
+    now.n_lng = telescope.GetLongitude() * PI / 180;
+    now.n_elev = telescope.GetAltitude() / ERAD;
+    now.n_temp = 15;
+    now.n_dip = now.n_tz = 0;
+    now.n_pressure = 1010;
+    now.n_epoch = J2000;
+
+    STATS_TIMER("candidates/twilight");
+    double julian_twilight_dawn;
+    double julian_twilight_dusk;
+    int status;
+    STATS_COUNT(TWILIGHT_CALLS, 1);
+    twilight_cir(&now, -17.5 * PI / 180, &julian_twilight_dawn,
+                 &julian_twilight_dusk, &status);
+
+    // Far from Greenwich twilight_cir() may give the dawn and dusk of
+    // different nights, which leave no slots
+    int total_observation_time = std::max(
+        0, (int)trunc((julian_twilight_dusk - julian_twilight_dawn) * 60 * 24));
+    horizon = total_observation_time;
+    dusk = julian_twilight_dusk;
+
+    std::cout << julian_twilight_dawn << std::endl;
+    std::cout << julian_twilight_dusk << std::endl;
+    std::cout << total_observation_time << std::endl;
+
+    TelescopeLimits limits = telescope.GetLimits();
+    std::vector<std::pair<PLCode, double>> planets;
+    for (auto planet : {std::make_pair(VENUS, limits.MinVenusDistance),
+                        std::make_pair(JUPITER, limits.MinJupiterDistance),
+                        std::make_pair(SATURN, limits.MinSaturnDistance)}) {
+        if (planet.second > 0) {
+            planets.push_back(planet);
+        }
+    }
+
+    if (total_observation_time <= 0) {
+        planets.clear();
+    }
+
+    std::vector<PLCode> planet_codes;
+    for (auto planet : planets) {
+        planet_codes.push_back(planet.first);
+    }
+
+    STATS_NEXT("candidates/grid");
+    NightGrid grid(julian_twilight_dusk, total_observation_time,
+                   telescope.GetLongitude(), planet_codes);
+
+    STATS_NEXT("candidates/ephemeris");
+    std::vector<Obj> bodies;
+    std::vector<size_t> moving;
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (objects[i].IsMoving()) {
+            bodies.push_back(objects[i].GetElements());
+            moving.push_back(i);
+        }
+    }
+
+    auto fits = Ephemeris::FitBatch(
+        now, bodies, julian_twilight_dusk,
+        julian_twilight_dusk + (double)total_observation_time / (24 * 60),
+        EPHEMERIS_KNOTS);
+    std::vector<Ephemeris> ephemerides(objects.size());
+    for (size_t k = 0; k < moving.size(); k++) {
+        ephemerides[moving[k]] = fits[k];
+    }
+
+    // Fixed objects are where the catalog puts them, only moving ones
+    // evaluate their fit
+    auto position = [&](size_t i, double time) {
+        if (!objects[i].IsMoving()) {
+            return objects[i].GetPosition();
+        }
+
+        return SkyPosition{ephemerides[i].GetRa(time),
+                           ephemerides[i].GetDec(time)};
+    };
+
+    // Mount and altitude limits only need the grid's sidereal time; the
+    // altitude limit becomes an hour angle bound, solved once per fixed
+    // object and once per slot for moving ones
+    STATS_NEXT("candidates/visibility");
+    STATS_COUNT(VISIBILITY_EVALUATIONS,
+                (int64_t)objects.size() * total_observation_time);
+    std::vector<Visibility> visibilities;
+    for (size_t i = 0; i < objects.size(); i++) {
+        bool is_moving = objects[i].IsMoving();
+        double max_hour_angle =
+            telescope.GetMaxHourAngle(objects[i].GetDec());
+        visibilities.push_back(
+            Visibility::Scan(total_observation_time, [&](int slot) {
+                SkyPosition object = position(i, grid.GetTime(slot));
+                if (is_moving) {
+                    max_hour_angle = telescope.GetMaxHourAngle(object.Dec);
+                }
+
+                return telescope.IsWithinLimits(grid.GetLst(slot),
+                                                object) &&
+                       fabs(Telescope::HourAngle(grid.GetLst(slot),
+                                                 object.Ra)) <=
+                           max_hour_angle;
+            }));
+    }
+
+    // Moon: one cone query per slot rejects whole cells of the catalog,
+    // moving objects are not indexed and are tested one by one
+    STATS_NEXT("candidates/moon");
+    double min_lunar_distance = telescope.GetLimits().MinLunarDistance;
+    for (int slot = 0; slot < grid.GetSlots(); slot++) {
+        for (int i : index.Cone(grid.GetMoonRa(slot),
+                                grid.GetMoonDec(slot),
+                                min_lunar_distance)) {
+            visibilities[i].Clear(slot);
+        }
+
+        for (size_t i : moving) {
+            if (visibilities[i].Test(slot) &&
+                telescope.IsNearMoon(
+                    grid.GetMoonRa(slot), grid.GetMoonDec(slot),
+                    position(i, grid.GetTime(slot)))) {
+                visibilities[i].Clear(slot);
+            }
+        }
+    }
+
+    // Planets move less than a degree per night: one cone around the
+    // middle of their track, widened by the drift, finds every candidate
+    STATS_NEXT("candidates/planets");
+    for (auto planet : planets) {
+        PLCode code = planet.first;
+        double distance = planet.second;
+        int middle = grid.GetSlots() / 2;
+        double center_ra = grid.GetPlanetRa(code, middle);
+        double center_dec = grid.GetPlanetDec(code, middle);
+
+        double drift = 0;
+        for (int slot : {0, grid.GetSlots() - 1}) {
+            drift = std::max(
+                drift, raddeg(Angle::separation(
+                                  degrad(grid.GetPlanetDec(code, slot)),
+                                  hrrad(grid.GetPlanetRa(code, slot)),
+                                  degrad(center_dec), hrrad(center_ra))
+                                  .GetRadians()));
+        }
+
+        std::vector<size_t> candidates = moving;
+        for (int i : index.Cone(center_ra, center_dec, distance + drift)) {
+            candidates.push_back(i);
+        }
+
+        for (size_t i : candidates) {
+            for (int slot = 0; slot < grid.GetSlots(); slot++) {
+                if (visibilities[i].Test(slot) &&
+                    Telescope::IsNear(grid.GetPlanetRa(code, slot),
+                                      grid.GetPlanetDec(code, slot),
+                                      distance,
+                                      position(i, grid.GetTime(slot)))) {
+                    visibilities[i].Clear(slot);
+                }
+            }
+        }
+    }
+
+    STATS_NEXT("candidates/satellites");
+    auto tracks = SatelliteTracks::Propagate(now, satellites,
+                                             julian_twilight_dusk,
+                                             total_observation_time,
+                                             SATELLITE_SAMPLES);
+
+    STATS_NEXT("candidates/windows");
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < objects.size(); i++) {
+        const Object &object = objects[i];
+        tracks.Mask(visibilities[i], julian_twilight_dusk,
+                    telescope.GetLimits().MinSatelliteDistance,
+                    [&](double time) { return position(i, time); });
+
+        // Pieces of splittable objects, and visits of monitored ones, go in
+        // any window fitting one of them
+        if (object.IsSplittable() || object.IsMonitored()) {
+            Cadence cadence = object.GetCadence();
+            auto windows = FindWindows(visibilities[i],
+                                       object.IsMonitored()
+                                           ? object.GetObservationTime()
+                                           : object.GetMinChunk());
+            int usable = 0;
+            for (Window window : windows) {
+                usable += window.Length();
+            }
+
+            if (windows.empty()) {
+                continue;
+            }
+
+            int chain = (cadence.Visits - 1) * cadence.MinSeparation +
+                        object.GetObservationTime();
+            if (object.IsMonitored()
+                    ? windows.back().End - windows.front().Start < chain
+                    : usable < (int)object.GetObservationTime()) {
+                continue;
+            }
+
+            Window span{windows.front().Start, windows.back().End};
+            std::cout << "Object added: " << telescope.GetId() << " - "
+                      << object.GetId() << " - " << span.Start << " - "
+                      << span.End << " - " << object.GetObservationTime()
+                      << " in " << windows.size() << " windows" << std::endl;
+
+            SkyPosition middle =
+                position(i, grid.GetTime((span.Start + span.End) / 2));
+            candidates.push_back(Candidate{
+                telescope_index, (int)i, span, AirmassCurve(), middle.GetRa(),
+                middle.GetDec(), object.GetConfiguration(), windows});
+            continue;
+        }
+
+        // Satellite trails and the Moon may split the night, any run long
+        // enough will do and the longest leaves the most room
+        Window window = FindLongestWindow(visibilities[i],
+                                          object.GetObservationTime());
+        if (window.Start == total_observation_time) {
+            continue;
+        }
+
+        std::cout << "Object added: " << telescope.GetId() << " - "
+                  << object.GetId() << " - " << window.Start << " - "
+                  << window.End << " - " << object.GetObservationTime()
+                  << std::endl;
+
+        auto curve = AirmassCurve::Compute(
+            telescope, grid, window, object.GetObservationTime(),
+            [&](double time) { return position(i, time); }, AIRMASS_SEGMENTS,
+            AIRMASS_TOLERANCE);
+        SkyPosition middle =
+            position(i, grid.GetTime((window.Start + window.End) / 2));
+        candidates.push_back(Candidate{telescope_index, (int)i, window, curve,
+                                       middle.GetRa(), middle.GetDec(),
+                                       object.GetConfiguration(), {}});
+    }
+
+    return candidates;
+}
+
+// Both orders of every sparse pair of candidates, each leaving room for the
+// slew between every piece of one and every piece of the other, only
+// constrain the model when both pieces are scheduled
+void AddSlewTransitions(
+    operations_research::sat::CpModelBuilder &model,
+    const std::vector<Transition> &transitions,
+    const std::vector<std::vector<operations_research::sat::IntervalVar>>
+        &pieces) {
+    using namespace operations_research::sat;
+
+    for (const Transition &transition : transitions) {
+        for (IntervalVar from : pieces[transition.From]) {
+            for (IntervalVar to : pieces[transition.To]) {
+                BoolVar before = model.NewBoolVar();
+                model
+                    .AddLessOrEqual(from.EndExpr() + transition.Time,
+                                    to.StartExpr())
+                    .OnlyEnforceIf({before, from.PresenceBoolVar(),
+                                    to.PresenceBoolVar()});
+                model
+                    .AddLessOrEqual(to.EndExpr() + transition.Time,
+                                    from.StartExpr())
+                    .OnlyEnforceIf({before.Not(), from.PresenceBoolVar(),
+                                    to.PresenceBoolVar()});
+            }
+        }
+    }
+}
+
+// Intervals of one telescope, each followed by `padding` minutes, for the
+// no-overlap of that telescope: the shortest transition between any two
+// candidates holds without a pair of its own
+std::vector<operations_research::sat::IntervalVar>
+PaddedIntervals(operations_research::sat::CpModelBuilder &model,
+                const std::vector<operations_research::sat::IntervalVar>
+                    &intervals,
+                int padding) {
+    using namespace operations_research::sat;
+
+    if (padding <= 0) {
+        return intervals;
+    }
+
+    std::vector<IntervalVar> padded;
+    for (IntervalVar interval : intervals) {
+        padded.push_back(model.NewOptionalIntervalVar(
+            interval.StartExpr(), interval.SizeExpr() + padding,
+            interval.EndExpr() + padding, interval.PresenceBoolVar()));
+    }
+
+    return padded;
+}
+
+// Model of one independent part of the night and the variables its
+// solution is read from. The variables point back to `Model`, so components
+// are built in place and never moved.
+struct ComponentModel {
+    operations_research::sat::CpModelBuilder Model;
+    operations_research::sat::CpModelProto Proto;
+    operations_research::sat::CpSolverResponse Response;
+    std::map<std::tuple<int, int>, operations_research::sat::IntVar> Assigned;
+    std::map<std::tuple<int, int>, operations_research::sat::BoolVar>
+        Presences;
+    std::map<std::tuple<int, int>,
+             std::vector<operations_research::sat::IntervalVar>>
+        Chunks;
+    std::map<int, operations_research::sat::IntVar> Makespans;
+    std::vector<operations_research::sat::IntVar> AirmassCosts;
+    VariableNames Names;
+    std::string Fingerprint;
+    std::vector<int> Demands;
+    int Candidates = 0;
+    int Blocks = 0;
+    int CandidateVariables = 0;
+    int CandidateConstraints = 0;
+    int Hinted = 0;
+    bool Cached = false;
+};
+
+// Builds the model of the candidates in `members`, given per telescope as
+// indices into `telescope_candidates`. Objects in `hinted` were already
+// placed by the batching hint of another telescope. `origins` shifts the
+// minutes of each telescope onto the common clock of shared resources.
+void BuildComponent(ComponentModel &component,
+                    const std::vector<Telescope> &telescopes,
+                    const std::vector<Object> &objects,
+                    const std::vector<std::vector<Candidate>> &telescope_candidates,
+                    const std::vector<std::vector<int>> &members,
+                    const std::vector<int> &horizons,
+                    const std::vector<int> &origins,
+                    const std::vector<Resource> &resources,
+                    std::vector<bool> &hinted) {
+    using namespace operations_research::sat;
+
+    CpModelBuilder &model = component.Model;
+    std::map<int, std::vector<BoolVar>> candidates_per_object;
+    std::vector<BoolVar> scheduled_literals;
+    std::vector<int64_t> priorities;
+    int64_t tiebreak_bound = 0;
+    std::vector<std::vector<std::pair<IntervalVar, int64_t>>> demands(
+        resources.size());
+
+    for (size_t t = 0; t < telescopes.size(); t++) {
+        if (members[t].empty()) {
+            continue;
+        }
+
+        const Telescope &telescope = telescopes[t];
+        int total_observation_time = horizons[t];
+        std::vector<Candidate> candidates;
+        for (int i : members[t]) {
+            candidates.push_back(telescope_candidates[t][i]);
+        }
+        component.Candidates += candidates.size();
+        int variables_before = model.Proto().variables_size();
+        int constraints_before = model.Proto().constraints_size();
+
+        IntVar makespan =
+            component.Names.Name(model.NewIntVar({0, total_observation_time}),
+                                 VariableNames::MAKESPAN, telescope.GetId());
+        std::vector<IntervalVar> intervals;
+        std::vector<IntVar> starts;
+        std::vector<BoolVar> candidate_presences;
+        std::vector<std::vector<IntervalVar>> candidate_pieces;
+        tiebreak_bound += total_observation_time;
+
+        // Demands are placed on the common clock
+        auto demand = [&](IntervalVar interval, const Object &object) {
+            if (object.GetDemands().empty()) {
+                return;
+            }
+
+            IntervalVar shared = interval;
+            if (origins[t] != 0) {
+                shared = model.NewOptionalIntervalVar(
+                    interval.StartExpr() + origins[t], interval.SizeExpr(),
+                    interval.EndExpr() + origins[t],
+                    interval.PresenceBoolVar());
+            }
+
+            for (ResourceDemand item : object.GetDemands()) {
+                demands[item.Resource].push_back({shared, item.Amount});
+            }
+        };
+
+        for (const Candidate &candidate : candidates) {
+            const Object &object = objects[candidate.ObjectIndex];
+            int visible_start = candidate.Visible.Start;
+            int visible_end = candidate.Visible.End;
+
+            VariableNames &names = component.Names;
+            int telescope_id = telescope.GetId();
+            int object_id = object.GetId();
+            auto key = std::make_tuple(telescope_id, object_id);
+            if (candidate.IsSplit()) {
+                BoolVar presence =
+                    names.Name(model.NewBoolVar(), VariableNames::SCHEDULE,
+                               telescope_id, object_id);
+                auto pieces =
+                    object.IsMonitored()
+                        ? AddVisits(model, candidate, object, presence, names,
+                                    telescope_id)
+                        : AddChunks(model, candidate, object, presence,
+                                    SPLIT_CHUNKS, names, telescope_id);
+                for (IntervalVar piece : pieces) {
+                    intervals.push_back(piece);
+                    demand(piece, object);
+
+                    model.AddLessOrEqual(piece.EndExpr(), makespan)
+                        .OnlyEnforceIf(piece.PresenceBoolVar());
+                }
+
+                component.Presences[key] = presence;
+                component.Chunks[key] = pieces;
+                candidate_pieces.push_back(pieces);
+                starts.push_back(model.NewConstant(visible_start));
+                candidate_presences.push_back(presence);
+                candidates_per_object[object.GetId()].push_back(presence);
+                scheduled_literals.push_back(presence);
+                priorities.push_back(object.GetPriority() + 1);
+                continue;
+            }
+
+            IntVar start =
+                names.Name(model.NewIntVar({visible_start, visible_end}),
+                           VariableNames::TWILIGHT_START, telescope_id,
+                           object_id);
+            IntVar end =
+                names.Name(model.NewIntVar({visible_start, visible_end}),
+                           VariableNames::OBJECT_END, telescope_id, object_id);
+            BoolVar presence =
+                names.Name(model.NewBoolVar(), VariableNames::SCHEDULE,
+                           telescope_id, object_id);
+            IntervalVar interval = names.Name(
+                model.NewOptionalIntervalVar(start, object.GetObservationTime(),
+                                             end, presence),
+                VariableNames::OBJECT_INTERVAL, telescope_id, object_id);
+            component.Assigned[key] = start;
+            component.Presences[key] = presence;
+            intervals.push_back(interval);
+            candidate_pieces.push_back({interval});
+            demand(interval, object);
+            starts.push_back(start);
+            candidate_presences.push_back(presence);
+            candidates_per_object[object.GetId()].push_back(presence);
+
+            // Priority 0 objects are still worth observing
+            scheduled_literals.push_back(presence);
+            priorities.push_back(object.GetPriority() + 1);
+
+            model.AddLessOrEqual(end, makespan).OnlyEnforceIf(presence);
+
+            component.AirmassCosts.push_back(
+                AddAirmassCost(model, start, presence, candidate.Airmass,
+                               names, telescope_id, object_id));
+            // A cost never exceeds the top of its curve
+            tiebreak_bound += candidate.Airmass.GetMaxCost();
+        }
+
+        component.CandidateVariables +=
+            model.Proto().variables_size() - variables_before;
+        component.CandidateConstraints +=
+            model.Proto().constraints_size() - constraints_before;
+
+        AddSlewTransitions(
+            model, SlewTransitions(telescope, candidates, SLEW_NEIGHBOURS),
+            candidate_pieces);
+
+        // Start the search from the candidates batched by configuration
+        auto blocks = ConfigurationBlocks(candidates);
+        auto batched =
+            BatchedStarts(telescope, candidates, blocks, objects, hinted);
+        for (size_t k = 0; k < candidates.size(); k++) {
+            if (candidates[k].IsSplit()) {
+                continue;
+            }
+
+            model.AddHint(candidate_presences[k], batched[k] >= 0);
+            if (batched[k] >= 0) {
+                model.AddHint(starts[k], batched[k]);
+            }
+        }
+        component.Blocks += blocks.size();
+
+        model.AddNoOverlap(
+            PaddedIntervals(model, intervals, MinTransitionTime(telescope)));
+        component.Makespans.emplace(telescope.GetId(), makespan);
+    }
+
+    // Shared resources hold every interval of every telescope, on the clock
+    // of the earliest dusk
+    for (size_t r = 0; r < resources.size(); r++) {
+        component.Demands.push_back(demands[r].size());
+        if (demands[r].empty()) {
+            continue;
+        }
+
+        CumulativeConstraint cumulative =
+            model.AddCumulative(resources[r].Capacity);
+        for (auto demand : demands[r]) {
+            cumulative.AddDemand(demand.first, demand.second);
+        }
+    }
+
+    // Each object is observed at most once, by any telescope
+    for (const auto &candidates : candidates_per_object) {
+        model.AddAtMostOne(candidates.second);
+    }
+
+    // Scheduled priority first; makespan and airmass (minutes against
+    // hundredths of airmass) only break ties, as their sum never reaches
+    // the weight of one priority point
+    int64_t priority_weight = tiebreak_bound + 1;
+    std::vector<int64_t> weights;
+    for (int64_t priority : priorities) {
+        weights.push_back(priority * priority_weight);
+    }
+
+    std::vector<IntVar> makespans;
+    for (auto item : component.Makespans) {
+        makespans.push_back(item.second);
+    }
+
+    model.Minimize(LinearExpr::Sum(makespans) +
+                   LinearExpr::Sum(component.AirmassCosts) -
+                   LinearExpr::WeightedSum(scheduled_literals, weights));
+
+    component.Proto = model.Build();
+}
+
+// `cache` is null when no cache directory was given
+void SolveComponent(ComponentModel &component,
+                    const operations_research::sat::SatParameters &parameters,
+                    const SolutionCache *cache) {
+    using namespace operations_research::sat;
+    TRACE_SPAN("solve", "candidates", component.Candidates);
+
+    if (cache != nullptr) {
+        component.Fingerprint =
+            SolutionCache::Fingerprint(component.Proto, parameters);
+        component.Cached =
+            cache->Find(component.Fingerprint, component.Response);
+        if (!component.Cached) {
+            component.Hinted =
+                cache->Hint(component.Fingerprint, component.Proto,
+                            component.Names.GetAll(
+                                component.Proto.variables_size()));
+        }
+    }
+
+    if (component.Cached) {
+        return;
+    }
+
+    if (Trace::IsEnabled()) {
+        // Improving solutions are marked on the thread that found them
+        Model model;
+        model.Add(NewSatParameters(parameters));
+        model.Add(NewFeasibleSolutionObserver(
+            [](const CpSolverResponse &response) {
+                Trace::Instant("solution", "objective",
+                               response.objective_value());
+            }));
+        component.Response = SolveCpModel(component.Proto, &model);
+    } else {
+        component.Response = SolveWithParameters(component.Proto, parameters);
+    }
+
+    if (cache != nullptr) {
+        cache->Store(component.Fingerprint,
+                     component.Names.GetAll(component.Proto.variables_size()),
+                     component.Response);
+    }
+}
+
+// Large components are solved one after another with every worker, the
+// small ones side by side on a worker each. A lone component keeps the
+// default parameters. The cache is opened once per run and shared by every
+// component.
+void SolveComponents(std::vector<ComponentModel> &components,
+                     const std::string &cache_directory) {
+    using namespace operations_research::sat;
+
+    std::unique_ptr<SolutionCache> cache;
+    if (!cache_directory.empty()) {
+        cache = std::make_unique<SolutionCache>(cache_directory,
+                                                CACHE_ENTRIES);
+    }
+
+    std::vector<int> small;
+    for (size_t c = 0; c < components.size(); c++) {
+        if (components.size() == 1 ||
+            components[c].Candidates >= LARGE_COMPONENT) {
+            SolveComponent(components[c], SatParameters(), cache.get());
+        } else {
+            small.push_back(c);
+        }
+    }
+
+    SatParameters parameters;
+    parameters.set_num_workers(1);
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t k = next++; k < small.size(); k = next++) {
+            SolveComponent(components[small[k]], parameters, cache.get());
+        }
+    };
+
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::min(threads, small.size()); i++) {
+        workers.emplace_back(work);
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    if (cache) {
+        std::vector<std::string> fingerprints;
+        for (const ComponentModel &component : components) {
+            fingerprints.push_back(component.Fingerprint);
+        }
+        cache->Finish(fingerprints);
+    }
+}
+
+SolverTelemetry Schedule(double julian_date, std::vector<Telescope> telescopes,
+                         std::vector<Object> objects,
+                         std::vector<Obj> satellites,
+                         std::vector<std::string> configurations,
+                         std::vector<Resource> resources,
+                         std::string cache_directory,
+                         bool model_names = true) {
+    using namespace operations_research::sat;
+    std::cout << "Implementation of the Scheduder with OR-Tools" << std::endl;
+
+    // The index is built in catalog order, which binary catalogs keep in
+    // cell order, and then follows the objects sorted by priority
+    SkyIndex index(objects);
+    std::vector<int> order(objects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](int a, int b) { return objects[a] < objects[b]; });
+
+    std::vector<int> positions(objects.size());
+    std::vector<Object> sorted;
+    sorted.reserve(objects.size());
+    for (size_t k = 0; k < order.size(); k++) {
+        positions[order[k]] = k;
+        sorted.push_back(std::move(objects[order[k]]));
+    }
+    objects = std::move(sorted);
+    index.Renumber(positions);
+
+    // Candidates are searched one telescope at a time: libastro is not
+    // thread-safe
+    STATS_TIMER("candidates");
+    STATS_COUNT(OBJECTS, objects.size());
+    std::vector<std::vector<Candidate>> telescope_candidates;
+    std::vector<int> horizons(telescopes.size());
+    std::vector<double> dusks(telescopes.size());
+    for (size_t t = 0; t < telescopes.size(); t++) {
+        telescope_candidates.push_back(
+            FindCandidates(julian_date, telescopes[t], t, objects, index,
+                           satellites, horizons[t], dusks[t]));
+    }
+
+    // Minutes from the earliest dusk to each telescope's own, for what
+    // telescopes share; nights without darkness have no candidates
+    double earliest = 0;
+    for (size_t t = 0; t < telescopes.size(); t++) {
+        if (horizons[t] > 0 && (earliest == 0 || dusks[t] < earliest)) {
+            earliest = dusks[t];
+        }
+    }
+    std::vector<int> origins(telescopes.size(), 0);
+    for (size_t t = 0; t < telescopes.size(); t++) {
+        if (horizons[t] > 0) {
+            origins[t] = llround((dusks[t] - earliest) * 24 * 60);
+        }
+    }
+
+    STATS_NEXT("presolve");
+    auto presolve = Presolve(telescope_candidates, telescopes, objects,
+                             PRESOLVE_NEIGHBOURS);
+
+    STATS_NEXT("components");
+    auto members = ConflictComponents(telescope_candidates, telescopes,
+                                      objects, resources.size(), origins);
+    STATS_NEXT("model");
+    std::vector<ComponentModel> components(members.size());
+    std::vector<bool> hinted(objects.size(), false);
+    for (size_t c = 0; c < components.size(); c++) {
+        components[c].Names = VariableNames(model_names);
+        BuildComponent(components[c], telescopes, objects,
+                       telescope_candidates, members[c], horizons, origins,
+                       resources, hinted);
+    }
+
+    int candidate_count = 0;
+    int largest = 0;
+    int blocks = 0;
+    int candidate_variables = 0;
+    int candidate_constraints = 0;
+    std::vector<int> demands(resources.size(), 0);
+    for (const ComponentModel &component : components) {
+        candidate_count += component.Candidates;
+        largest = std::max(largest, component.Candidates);
+        blocks += component.Blocks;
+        candidate_variables += component.CandidateVariables;
+        candidate_constraints += component.CandidateConstraints;
+        for (size_t r = 0; r < resources.size(); r++) {
+            demands[r] += component.Demands[r];
+        }
+
+        STATS_COUNT(VARIABLES, component.Proto.variables_size());
+        STATS_COUNT(CONSTRAINTS, component.Proto.constraints_size());
+    }
+
+    STATS_COUNT(CANDIDATES, candidate_count);
+    STATS_COUNT(COMPONENTS, components.size());
+
+    std::cout << "Configuration blocks: " << blocks << std::endl;
+    std::cout << "Components: " << components.size() << ", largest "
+              << largest << " candidates" << std::endl;
+
+    // Removed candidates would have cost about as much as the kept ones
+    int kept = presolve.Candidates - presolve.Removed;
+    std::cout << "Presolve: removed " << presolve.Removed << " of "
+              << presolve.Candidates << " candidates, "
+              << presolve.Saturated << " of " << presolve.Clusters
+              << " window clusters saturated" << std::endl;
+    if (kept > 0) {
+        std::cout << "Presolve: model shrank by about "
+                  << (int64_t)presolve.Removed * candidate_variables / kept
+                  << " variables and "
+                  << (int64_t)presolve.Removed * candidate_constraints / kept
+                  << " constraints" << std::endl;
+    }
+
+    for (size_t r = 0; r < resources.size(); r++) {
+        if (demands[r] > 0) {
+            std::cout << "Resource " << resources[r].Name << ": "
+                      << demands[r] << " candidates, capacity "
+                      << resources[r].Capacity << std::endl;
+        }
+    }
+
+    STATS_NEXT("search");
+    auto search_begin = std::chrono::steady_clock::now();
+    SolveComponents(components, cache_directory);
+    double search_time = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - search_begin)
+                             .count();
+
+    STATS_NEXT("report");
+
+    if (!cache_directory.empty()) {
+        int cached = 0;
+        int hinted_variables = 0;
+        for (const ComponentModel &component : components) {
+            cached += component.Cached;
+            hinted_variables += component.Hinted;
+        }
+
+        std::cout << "Components loaded from cache: " << cached << " of "
+                  << components.size() << std::endl;
+        std::cout << "Variables hinted from cache: " << hinted_variables
+                  << std::endl;
+    }
+
+    // The night is solved when every component is. A night without
+    // components was never solved, as the telemetry reports it
+    CpSolverStatus status = components.empty() ? CpSolverStatus::UNKNOWN
+                                               : CpSolverStatus::OPTIMAL;
+    for (const ComponentModel &component : components) {
+        CpSolverStatus component_status = component.Response.status();
+        if (component_status == CpSolverStatus::FEASIBLE &&
+            status == CpSolverStatus::OPTIMAL) {
+            status = CpSolverStatus::FEASIBLE;
+        } else if (component_status != CpSolverStatus::OPTIMAL &&
+                   component_status != CpSolverStatus::FEASIBLE) {
+            status = component_status;
+            break;
+        }
+    }
+
+    if (status == CpSolverStatus::OPTIMAL ||
+        status == CpSolverStatus::FEASIBLE) {
+        std::cout << "Solution found:" << std::endl;
+
+        // Split objects are listed by the start of their first piece
+        std::map<std::tuple<int, int>, int64_t> scheduled;
+        std::map<std::tuple<int, int>, ComponentModel *> owner;
+        for (ComponentModel &component : components) {
+            const CpSolverResponse &response = component.Response;
+            for (auto item : component.Presences) {
+                if (!SolutionBooleanValue(response, item.second)) {
+                    continue;
+                }
+
+                owner[item.first] = &component;
+                if (component.Chunks.count(item.first)) {
+                    scheduled[item.first] = SolutionIntegerValue(
+                        response,
+                        component.Chunks[item.first].front().StartExpr());
+                    continue;
+                }
+
+                auto val = SolutionIntegerValue(
+                    response, component.Assigned[item.first]);
+                scheduled[item.first] = val;
+            }
+        }
+
+        int64_t scheduled_priority = 0;
+        int64_t candidate_priority = 0;
+        int64_t observed_time = 0;
+        std::map<int, std::map<int64_t, int>> configuration_sequence;
+        for (const auto &value : scheduled) {
+            auto job_id = std::get<1>(value.first);
+            auto object = std::find_if(
+                objects.begin(), objects.end(),
+                [&job_id](const Object &obj) { return obj.GetId() == job_id; });
+            scheduled_priority += object->GetPriority() + 1;
+
+            ComponentModel &component = *owner[value.first];
+            if (component.Chunks.count(value.first)) {
+                const CpSolverResponse &response = component.Response;
+                int piece_number = 0;
+                for (IntervalVar piece : component.Chunks[value.first]) {
+                    piece_number++;
+                    if (!SolutionBooleanValue(response,
+                                              piece.PresenceBoolVar())) {
+                        continue;
+                    }
+
+                    auto start = SolutionIntegerValue(response,
+                                                      piece.StartExpr());
+                    auto size =
+                        SolutionIntegerValue(response, piece.SizeExpr());
+                    std::cout << "Telescope: " << std::get<0>(value.first)
+                              << " Job: " << job_id << " Starts at: " << start
+                              << " until " << start + size << " - " << size;
+                    if (object->IsMonitored()) {
+                        std::cout << " visit " << piece_number << " of "
+                                  << object->GetCadence().Visits;
+                    } else {
+                        std::cout << " of " << object->GetObservationTime();
+                    }
+                    std::cout << std::endl;
+                    observed_time += size;
+                    configuration_sequence[std::get<0>(value.first)][start] =
+                        object->GetConfiguration();
+                }
+
+                continue;
+            }
+
+            observed_time += object->GetObservationTime();
+            std::cout << "Telescope: " << std::get<0>(value.first)
+                      << " Job: " << job_id << " Starts at: " << value.second
+                      << " until "
+                      << value.second + object->GetObservationTime() << " - "
+                      << object->GetObservationTime();
+            if (object->GetConfiguration() != 0) {
+                std::cout << " - "
+                          << configurations[object->GetConfiguration()];
+            }
+            std::cout << std::endl;
+
+            configuration_sequence[std::get<0>(value.first)][value.second] =
+                object->GetConfiguration();
+        }
+
+        std::vector<bool> has_candidate(objects.size(), false);
+        for (const auto &candidates : telescope_candidates) {
+            for (const Candidate &candidate : candidates) {
+                has_candidate[candidate.ObjectIndex] = true;
+            }
+        }
+        for (size_t i = 0; i < objects.size(); i++) {
+            if (has_candidate[i]) {
+                candidate_priority += objects[i].GetPriority() + 1;
+            }
+        }
+
+        std::cout << "Scheduled objects: " << scheduled.size() << " of "
+                  << candidate_count << " candidates" << std::endl;
+        std::cout << "Scheduled priority: " << scheduled_priority << " of "
+                  << candidate_priority << std::endl;
+        std::cout << "Observed time: " << observed_time << std::endl;
+
+        int configuration_changes = 0;
+        for (const auto &sequence : configuration_sequence) {
+            int current = 0;
+            for (auto item : sequence.second) {
+                if (item.second != 0 && current != 0 && item.second != current) {
+                    configuration_changes++;
+                }
+                if (item.second != 0) {
+                    current = item.second;
+                }
+            }
+        }
+
+        std::cout << "Configuration changes: " << configuration_changes
+                  << std::endl;
+
+        // Each telescope's night ends with the last of its components
+        std::map<int, int64_t> makespans;
+        int64_t airmass_cost = 0;
+        double objective = 0;
+        for (const ComponentModel &component : components) {
+            for (auto item : component.Makespans) {
+                makespans[item.first] =
+                    std::max(makespans[item.first],
+                             SolutionIntegerValue(component.Response,
+                                                  item.second));
+            }
+            for (IntVar cost : component.AirmassCosts) {
+                airmass_cost += SolutionIntegerValue(component.Response, cost);
+            }
+            objective += component.Response.objective_value();
+        }
+
+        int64_t schedule_length = 0;
+        for (auto item : makespans) {
+            schedule_length += item.second;
+        }
+
+        std::cout << "Optimal Schedule Length: " << schedule_length
+                  << std::endl;
+        std::cout << "Mean airmass: "
+                  << 1 + (double)airmass_cost /
+                             (AirmassCurve::SCALE *
+                              std::max((size_t)1, scheduled.size()))
+                  << std::endl;
+        std::cout << "Objective value: " << objective << std::endl;
+    } else {
+        std::cout << "No solution was found" << std::endl;
+
+        // The origins are kept with or without names in the proto
+        for (const ComponentModel &component : components) {
+            CpSolverStatus component_status = component.Response.status();
+            if (component_status == CpSolverStatus::OPTIMAL ||
+                component_status == CpSolverStatus::FEASIBLE) {
+                continue;
+            }
+
+            std::set<int> component_telescopes;
+            std::set<int> component_objects;
+            for (const auto &origin : component.Names.GetOrigins()) {
+                component_telescopes.insert(origin.Telescope);
+                if (origin.Object >= 0) {
+                    component_objects.insert(origin.Object);
+                }
+            }
+
+            std::cout << "  " << CpSolverStatus_Name(component_status) << ": "
+                      << component_objects.size() << " objects on telescopes";
+            for (int telescope_id : component_telescopes) {
+                std::cout << " " << telescope_id;
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    // Statistics
+    SolverTelemetry telemetry;
+    telemetry.SetPresolve(presolve);
+    telemetry.SetWallTime(search_time);
+    for (const ComponentModel &component : components) {
+        telemetry.AddModel(component.Proto, component.Candidates);
+        telemetry.AddResponse(component.Response, component.Cached);
+    }
+
+    Stats::Section("model", telemetry.ModelJson());
+    Stats::Section("solver", telemetry.SolverJson());
+
+    std::cout << std::endl;
+    std::cout << "Statistics" << std::endl;
+    telemetry.Print(std::cout);
+
+    return telemetry;
+}
+
+#endif